@@ -0,0 +1,122 @@
+#pragma once
+
+#include "framebuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace My
+{
+    // running per-pixel sums of a progressive render. every pass adds its samples of a pixel as one
+    // float, so the sums only depend on the sequence of passes and not on when a run was interrupted
+    class accumulation_buffer
+    {
+    public:
+        accumulation_buffer() : image_width(0), image_height(0), pass_count(0) {}
+        accumulation_buffer(int width, int height)
+            : image_width(width), image_height(height), pass_count(0),
+              sums(static_cast<size_t>(width) * height * 3, 0.0f), luminance_sqs(static_cast<size_t>(width) * height, 0.0f),
+              counts(static_cast<size_t>(width) * height, 0) {}
+
+        int width() const { return image_width; }
+        int height() const { return image_height; }
+        size_t pixel_count() const { return static_cast<size_t>(image_width) * image_height; }
+
+        // passes completed over the whole image
+        uint32_t passes() const { return pass_count; }
+        void set_passes(uint32_t passes) { pass_count = passes; }
+
+        void add(size_t pixel_index, const color& sample_sum, double luminance_sq_sum, uint32_t sample_count) {
+            float* p = &sums[pixel_index * 3];
+            p[0] += static_cast<float>(sample_sum.x());
+            p[1] += static_cast<float>(sample_sum.y());
+            p[2] += static_cast<float>(sample_sum.z());
+            luminance_sqs[pixel_index] += static_cast<float>(luminance_sq_sum);
+            counts[pixel_index] += sample_count;
+        }
+
+        uint32_t samples(size_t pixel_index) const { return counts[pixel_index]; }
+
+        // standard error of the pixel's mean luminance relative to that mean, from the sample variance.
+        // means below 1e-3 count as 1e-3 so black pixels with a little noise can still converge
+        double relative_error(size_t pixel_index) const {
+            uint32_t n = counts[pixel_index];
+            if (n < 2)
+                return std::numeric_limits<double>::infinity();
+            const float* p = &sums[pixel_index * 3];
+            double mean = luminance(color(p[0], p[1], p[2])) / n;
+            double variance = std::max(0.0, (luminance_sqs[pixel_index] - n * mean * mean) / (n - 1));
+            return std::sqrt(variance / n) / std::max(mean, 1e-3);
+        }
+
+        // 1 for the pixels that still need samples: those with a relative error of at least threshold somewhere
+        // in their 3x3 neighbourhood. looking at the neighbours keeps a pixel whose few samples happened to agree
+        // from stopping early next to noisy ones
+        std::vector<uint8_t> active_pixels(double threshold, size_t& active_count) const {
+            std::vector<uint8_t> noisy(pixel_count());
+            for (size_t i = 0; i < pixel_count(); i++)
+                noisy[i] = !(relative_error(i) < threshold);
+
+            std::vector<uint8_t> active(pixel_count(), 0);
+            active_count = 0;
+            for (int j = 0; j < image_height; j++) {
+                for (int i = 0; i < image_width; i++) {
+                    uint8_t a = 0;
+                    for (int y = std::max(0, j - 1); y <= std::min(image_height - 1, j + 1) && !a; y++)
+                        for (int x = std::max(0, i - 1); x <= std::min(image_width - 1, i + 1) && !a; x++)
+                            a = noisy[static_cast<size_t>(y) * image_width + x];
+                    active[static_cast<size_t>(j) * image_width + i] = a;
+                    active_count += a;
+                }
+            }
+            return active;
+        }
+
+        uint64_t total_samples() const {
+            uint64_t total = 0;
+            for (auto n : counts) total += n;
+            return total;
+        }
+
+        // samples per pixel relative to the most sampled pixel, black through red and yellow to white
+        framebuffer sample_heatmap() const {
+            framebuffer image(image_width, image_height);
+            uint32_t most = counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+            for (size_t i = 0; i < pixel_count(); i++) {
+                double t = most > 0 ? static_cast<double>(counts[i]) / most : 0.0;
+                image.set(i, heatmap_color(t));
+            }
+            return image;
+        }
+
+        // the mean of every pixel
+        framebuffer resolve() const {
+            framebuffer image(image_width, image_height);
+            for (size_t i = 0; i < pixel_count(); i++) {
+                const float* p = &sums[i * 3];
+                double scale = counts[i] > 0 ? 1.0 / counts[i] : 0.0;
+                image.set(i, color(p[0] * scale, p[1] * scale, p[2] * scale));
+            }
+            return image;
+        }
+
+        float* sum_data() { return sums.data(); }
+        const float* sum_data() const { return sums.data(); }
+        float* luminance_sq_data() { return luminance_sqs.data(); }
+        const float* luminance_sq_data() const { return luminance_sqs.data(); }
+        uint32_t* count_data() { return counts.data(); }
+        const uint32_t* count_data() const { return counts.data(); }
+
+    private:
+        int image_width;
+        int image_height;
+        uint32_t pass_count;
+        std::vector<float> sums;        // rgb per pixel
+        std::vector<float> luminance_sqs;   // sum of the squared sample luminances per pixel
+        std::vector<uint32_t> counts;   // samples per pixel
+    };
+}
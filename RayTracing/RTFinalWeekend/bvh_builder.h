@@ -0,0 +1,405 @@
+#pragma once
+#include "aabb.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace My
+{
+    // one node of a flattened bvh. nodes are stored depth first, so the first child of an interior
+    // node is the node right after it and only the second child needs an offset
+    struct linear_bvh_node
+    {
+        float bounds_min[3];
+        float bounds_max[3];
+        uint32_t offset;    // leaf: first primitive, interior: second child
+        uint16_t count;     // primitives in the leaf, 0 for interior nodes
+        uint8_t axis;       // split axis of interior nodes
+        uint8_t pad;
+
+        bool is_leaf() const { return count > 0; }
+
+        // bounds are rounded outwards so the float box always contains the double one
+        void set_bounds(const aabb& box) {
+            for (int a = 0; a < 3; a++) {
+                const interval& ax = box.axis_interval(a);
+                bounds_min[a] = round_down(ax.min);
+                bounds_max[a] = round_up(ax.max);
+            }
+        }
+
+        // slab test; inv_dir and dir_is_neg are computed once per ray
+        bool hit(const point3& origin, const vec3& inv_dir, const int dir_is_neg[3], double tmin, double tmax) const {
+            RT_COUNT(box_tests);
+            for (int a = 0; a < 3; a++) {
+                double t0 = ((dir_is_neg[a] ? bounds_max[a] : bounds_min[a]) - origin[a]) * inv_dir[a];
+                double t1 = ((dir_is_neg[a] ? bounds_min[a] : bounds_max[a]) - origin[a]) * inv_dir[a];
+                if (t0 > tmin) tmin = t0;
+                if (t1 < tmax) tmax = t1;
+            }
+            // the slab distances are a few ulps off, without the slack a ray through an edge or corner of
+            // the box (a triangle vertex on it) could pass between the boxes on both sides
+            return tmin <= tmax * (1 + 4 * std::numeric_limits<double>::epsilon());
+        }
+
+        static float round_down(double x) {
+            auto f = static_cast<float>(x);
+            return (f > x) ? std::nextafter(f, -std::numeric_limits<float>::infinity()) : f;
+        }
+
+        static float round_up(double x) {
+            auto f = static_cast<float>(x);
+            return (f < x) ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f;
+        }
+    };
+
+    static_assert(sizeof(linear_bvh_node) == 32, "linear_bvh_node should stay 32 bytes");
+
+    enum class bvh_split { median, sah };
+
+    // the most levels below the root of a built tree. traversals keep one node per level on their stack,
+    // so a stack of this many entries never overflows
+    constexpr int bvh_max_depth = 64;
+
+    // the stack traversal of every flat tree. node_hit tests a node's bounds against the ray, and leaf handles
+    // the primitives of a leaf it let through. the near child is taken first and the far one stacked, as the
+    // split axis and dir_is_neg order them. node_hit should read the ray's interval by reference, so a leaf
+    // that shrinks it culls the rest of the walk. returns true as soon as leaf does, which is how a shadow
+    // query stops at its first occluder; a closest hit query returns false from every leaf
+    template <typename Node, typename NodeHit, typename Leaf>
+    bool traverse_bvh(const Node* nodes, const int dir_is_neg[3], NodeHit&& node_hit, Leaf&& leaf) {
+        uint32_t stack[bvh_max_depth];
+        int stack_size = 0;
+        uint32_t node_index = 0;
+
+        while (true) {
+            const Node& node = nodes[node_index];
+            RT_COUNT(node_visits);
+            if (node_hit(node)) {
+                if (!node.is_leaf()) {
+                    if (dir_is_neg[node.axis]) {
+                        stack[stack_size++] = node_index + 1;
+                        node_index = node.offset;
+                    } else {
+                        stack[stack_size++] = node.offset;
+                        node_index = node_index + 1;
+                    }
+                    continue;
+                }
+                if (leaf(node))
+                    return true;
+            }
+            if (stack_size == 0)
+                return false;
+            node_index = stack[--stack_size];
+        }
+    }
+
+    struct bvh_build_stats
+    {
+        double build_ms = 0;
+        double sah_cost = 0;        // expected cost of a ray through the root, in units of one primitive test
+        size_t node_count = 0;
+        size_t leaf_count = 0;
+        int max_depth = 0;
+    };
+
+    // builds the flat node array over a set of primitive bounds.
+    // the top of the tree is split serially until the ranges are small enough to hand out,
+    // then the subtrees are built in parallel and stitched together depth first
+    class bvh_builder
+    {
+    public:
+        bvh_split split = bvh_split::sah;
+        int bin_count = 16;             // sah buckets per axis, at most max_bins
+        int max_leaf_size = 4;
+        double traversal_cost = 0.125;  // cost of visiting a node relative to one primitive test
+        int thread_count = 0;           // subtree build threads, 0 uses every hardware thread
+
+        // order receives the primitive indices in leaf order; leaves address ranges of it
+        std::vector<linear_bvh_node> build(const std::vector<aabb>& bounds, std::vector<uint32_t>& order,
+                                           bvh_build_stats* stats = nullptr) const {
+            auto start = std::chrono::steady_clock::now();
+
+            std::vector<prim_ref> refs(bounds.size());
+            for (size_t i = 0; i < bounds.size(); i++) {
+                refs[i].bounds = bounds[i];
+                refs[i].centroid = centroid(bounds[i]);
+                refs[i].index = static_cast<uint32_t>(i);
+            }
+
+            std::vector<linear_bvh_node> nodes;
+            if (!refs.empty()) {
+                thread_pool pool(thread_count);
+                size_t task_size = refs.size();
+                if (pool.size() > 1)
+                    task_size = std::max(min_task_size, refs.size() / (4 * static_cast<size_t>(pool.size())));
+
+                std::vector<build_node> top;
+                std::vector<range> tasks;
+                build_recursive(refs, 0, refs.size(), 0, top, task_size, &tasks);
+
+                std::vector<std::vector<build_node>> subtrees(tasks.size());
+                pool.parallel_for(static_cast<int>(tasks.size()), [&](int t, int) {
+                    subtrees[t].reserve(2 * (tasks[t].end - tasks[t].start));
+                    build_recursive(refs, tasks[t].start, tasks[t].end, tasks[t].depth, subtrees[t], 0, nullptr);
+                });
+
+                nodes.reserve(2 * refs.size());
+                int max_depth = 0;
+                flatten(top, 0, subtrees, nodes, 0, max_depth);
+
+                if (stats) stats->max_depth = max_depth;
+            }
+
+            order.resize(refs.size());
+            for (size_t i = 0; i < refs.size(); i++)
+                order[i] = refs[i].index;
+
+            if (stats) {
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                stats->build_ms = elapsed.count();
+                stats->node_count = nodes.size();
+                stats->leaf_count = 0;
+                stats->sah_cost = 0;
+
+                if (!nodes.empty()) {
+                    double root_area = node_area(nodes[0]);
+                    for (const auto& node : nodes) {
+                        double p = root_area > 0 ? node_area(node) / root_area : 1;
+                        stats->sah_cost += traversal_cost * p;
+                        if (node.is_leaf()) {
+                            stats->leaf_count++;
+                            stats->sah_cost += node.count * p;
+                        }
+                    }
+                }
+            }
+
+            return nodes;
+        }
+
+    private:
+        static constexpr size_t min_task_size = 256;
+        static constexpr int max_bins = 32;
+
+        struct prim_ref {
+            aabb bounds;
+            point3 centroid;
+            uint32_t index;
+        };
+
+        struct range {
+            size_t start, end;
+            int depth;
+        };
+
+        // node of the intermediate tree. interior nodes have their first child right after them,
+        // placeholders (task >= 0) stand for a subtree built by a task
+        struct build_node {
+            aabb bounds;
+            uint32_t second = 0;
+            uint32_t offset = 0;
+            uint32_t count = 0;
+            int axis = 0;
+            int task = -1;
+        };
+
+        struct bin {
+            aabb bounds = aabb::empty;
+            size_t count = 0;
+        };
+
+        // plain union without aabb's minimum padding, for the inner loops
+        static void grow(aabb& box, const aabb& other) {
+            box.x = interval(std::min(box.x.min, other.x.min), std::max(box.x.max, other.x.max));
+            box.y = interval(std::min(box.y.min, other.y.min), std::max(box.y.max, other.y.max));
+            box.z = interval(std::min(box.z.min, other.z.min), std::max(box.z.max, other.z.max));
+        }
+
+        static void grow(aabb& box, const point3& p) {
+            box.x = interval(std::min(box.x.min, p.x()), std::max(box.x.max, p.x()));
+            box.y = interval(std::min(box.y.min, p.y()), std::max(box.y.max, p.y()));
+            box.z = interval(std::min(box.z.min, p.z()), std::max(box.z.max, p.z()));
+        }
+
+        static point3 centroid(const aabb& box) {
+            return point3(0.5 * (box.x.min + box.x.max), 0.5 * (box.y.min + box.y.max), 0.5 * (box.z.min + box.z.max));
+        }
+
+        static double node_area(const linear_bvh_node& node) {
+            double dx = double(node.bounds_max[0]) - node.bounds_min[0];
+            double dy = double(node.bounds_max[1]) - node.bounds_min[1];
+            double dz = double(node.bounds_max[2]) - node.bounds_min[2];
+            return 2 * (dx * dy + dy * dz + dz * dx);
+        }
+
+        static int bin_index(double c, double min, double extent, int bins) {
+            int b = static_cast<int>(bins * ((c - min) / extent));
+            return std::min(std::max(b, 0), bins - 1);
+        }
+
+        // levels of median splits below a range of count primitives before its leaves
+        static int balanced_depth(size_t count) {
+            int levels = 0;
+            while ((size_t(1) << levels) < count)
+                levels++;
+            return levels;
+        }
+
+        // picks a split of [start, end), partitions refs around it and returns the first index of the second half.
+        // returns start when the range should stay a leaf
+        size_t split_range(std::vector<prim_ref>& refs, size_t start, size_t end, int depth,
+                           const aabb& bbox, const aabb& centroid_bounds, int& axis) const {
+            size_t count = end - start;
+            axis = centroid_bounds.longest_axis();
+            bool can_be_leaf = count <= static_cast<size_t>(max_leaf_size);
+
+            auto median_split = [&]() {
+                size_t mid = start + count / 2;
+                std::nth_element(refs.begin() + start, refs.begin() + mid, refs.begin() + end,
+                    [this_axis = axis](const prim_ref& a, const prim_ref& b) { return a.centroid[this_axis] < b.centroid[this_axis]; });
+                return mid;
+            };
+
+            // sah can split off a few primitives per level, on geometrically spaced ones all the way down.
+            // once only halving the rest still fits under bvh_max_depth, the range is halved
+            bool balance = depth + balanced_depth(count) >= bvh_max_depth;
+            if (split == bvh_split::median || balance || centroid_bounds.axis_interval(axis).size() <= 0)
+                return can_be_leaf ? start : median_split();
+
+            // binned sah: sweep the bucket boundaries of every axis and keep the cheapest plane
+            double best_cost = infinity;
+            int best_axis = -1;
+            int best_bin = 0;
+            int bins_used = std::min(std::max(bin_count, 2), max_bins);
+            bin bins[max_bins];
+            double right_area[max_bins];
+            size_t right_count[max_bins];
+
+            for (int a = 0; a < 3; a++) {
+                const interval& c_axis = centroid_bounds.axis_interval(a);
+                double extent = c_axis.size();
+                if (extent <= 0) continue;
+
+                std::fill(bins, bins + bins_used, bin());
+                for (size_t i = start; i < end; i++) {
+                    auto& b = bins[bin_index(refs[i].centroid[a], c_axis.min, extent, bins_used)];
+                    grow(b.bounds, refs[i].bounds);
+                    b.count++;
+                }
+
+                aabb right_box = aabb::empty;
+                size_t right_n = 0;
+                for (int b = bins_used - 1; b > 0; b--) {
+                    grow(right_box, bins[b].bounds);
+                    right_n += bins[b].count;
+                    right_area[b] = right_n ? right_box.surface_area() : 0;
+                    right_count[b] = right_n;
+                }
+
+                aabb left_box = aabb::empty;
+                size_t left_n = 0;
+                for (int b = 1; b < bins_used; b++) {
+                    grow(left_box, bins[b - 1].bounds);
+                    left_n += bins[b - 1].count;
+                    if (left_n == 0 || right_count[b] == 0) continue;
+
+                    double cost = left_box.surface_area() * left_n + right_area[b] * right_count[b];
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = a;
+                        best_bin = b;
+                    }
+                }
+            }
+
+            if (best_axis < 0)
+                return can_be_leaf ? start : median_split();
+
+            double area = bbox.surface_area();
+            double split_cost = traversal_cost + (area > 0 ? best_cost / area : 0);
+            if (can_be_leaf && static_cast<double>(count) <= split_cost)
+                return start;
+
+            axis = best_axis;
+            const interval& c_axis = centroid_bounds.axis_interval(axis);
+            double extent = c_axis.size();
+            auto mid_it = std::partition(refs.begin() + start, refs.begin() + end, [&](const prim_ref& r) {
+                return bin_index(r.centroid[axis], c_axis.min, extent, bins_used) < best_bin;
+            });
+
+            size_t mid = static_cast<size_t>(mid_it - refs.begin());
+            if (mid == start || mid == end)
+                return median_split();
+            return mid;
+        }
+
+        uint32_t build_recursive(std::vector<prim_ref>& refs, size_t start, size_t end, int depth,
+                                 std::vector<build_node>& dst, size_t task_size, std::vector<range>* tasks) const {
+            auto node_index = static_cast<uint32_t>(dst.size());
+            dst.emplace_back();
+
+            if (tasks && end - start <= task_size) {
+                dst[node_index].task = static_cast<int>(tasks->size());
+                tasks->push_back({ start, end, depth });
+                return node_index;
+            }
+
+            aabb bbox = aabb::empty;
+            aabb centroid_bounds = aabb::empty;
+            for (size_t i = start; i < end; i++) {
+                grow(bbox, refs[i].bounds);
+                grow(centroid_bounds, refs[i].centroid);
+            }
+            dst[node_index].bounds = bbox;
+
+            int axis;
+            size_t mid = split_range(refs, start, end, depth, bbox, centroid_bounds, axis);
+            if (mid == start) {
+                dst[node_index].offset = static_cast<uint32_t>(start);
+                dst[node_index].count = static_cast<uint32_t>(end - start);
+                return node_index;
+            }
+
+            build_recursive(refs, start, mid, depth + 1, dst, task_size, tasks);
+            uint32_t second = build_recursive(refs, mid, end, depth + 1, dst, task_size, tasks);
+
+            dst[node_index].second = second;
+            dst[node_index].axis = axis;
+            return node_index;
+        }
+
+        uint32_t flatten(const std::vector<build_node>& src, uint32_t index, const std::vector<std::vector<build_node>>& subtrees,
+                         std::vector<linear_bvh_node>& nodes, int depth, int& max_depth) const {
+            const build_node& b = src[index];
+            if (b.task >= 0)
+                return flatten(subtrees[b.task], 0, subtrees, nodes, depth, max_depth);
+
+            max_depth = std::max(max_depth, depth);
+            auto out = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+            nodes[out].set_bounds(b.bounds);
+            nodes[out].pad = 0;
+
+            if (b.count > 0) {
+                nodes[out].offset = b.offset;
+                nodes[out].count = static_cast<uint16_t>(b.count);
+                nodes[out].axis = 0;
+                return out;
+            }
+
+            flatten(src, index + 1, subtrees, nodes, depth + 1, max_depth);
+            uint32_t second = flatten(src, b.second, subtrees, nodes, depth + 1, max_depth);
+
+            nodes[out].offset = second;
+            nodes[out].count = 0;
+            nodes[out].axis = static_cast<uint8_t>(b.axis);
+            return out;
+        }
+    };
+}
@@ -1,148 +1,586 @@
-#pragma once
-
-#include "hittable.h"
-#include "color.h"
-#include "material.h"
-
-namespace My {
-    class camera {
-        public:
-            double aspect_ratio = 1.0;
-            int image_width = 100;
-            int samples_per_pixel = 10;     // count of random samples for each pixel
-            int max_depth = 10;             // maximum number of ray bounces into scene
-            color background = color(0, 0, 0);
-
-            double vfov = 90;
-            // camera space
-            point3 lookfrom = point3(0, 0, 0);
-            point3 lookat = point3(0, 0, -1);
-            vec3 vup = vec3(0, 1, 0);
-
-            double defocus_angle = 0;       // variation angle of rays through each pixel
-            double focus_dist = 10;         // distance from camera lookfrom point to plane of perfect focus
-
-            void render(const hittable& world) {
-                initialize();
-
-                std::cout << "P3\n" << image_width << " " << image_height << "\n255\n";
-
-                for (int j = 0; j < image_height; j++) {
-                    std::clog << "\rScanlines remaining: " << image_height - j << std::flush;
-                    for (int i = 0; i < image_width; i++) {
-                        color pixel_color(0, 0, 0);
-                        for (int s_j = 0; s_j < sqrt_spp; s_j++) {
-                            for (int s_i = 0; s_i < sqrt_spp; s_i++) {
-                                ray r = get_ray(i, j, s_i, s_j);
-                                pixel_color += ray_color(r, max_depth, world);
-                            }
-                        }
-                      
-                        write_color(std::cout, pixel_samples_scale * pixel_color);
-                    }
-                }
-
-                std::clog << "\rDone.                       \n";
-            }
-
-        private:
-            int image_height;
-            double pixel_samples_scale;
-            int sqrt_spp;
-            double recip_sqrt_spp;
-            point3 center;
-            point3 pixel00_loc;
-            vec3 pixel_delta_u;
-            vec3 pixel_delta_v;
-            vec3 u, v, w;                   // camera from basis vectors
-            vec3 defocus_disk_u;
-            vec3 defocus_disk_v;
-
-            void initialize() {
-                image_height = static_cast<int>(image_width / aspect_ratio);
-                image_height = (image_height < 1) ? 1 : image_height;
-
-                sqrt_spp = static_cast<int>(std::sqrt(samples_per_pixel));
-                pixel_samples_scale = 1.0 / (sqrt_spp * sqrt_spp);
-                recip_sqrt_spp = 1.0 / sqrt_spp;
-
-                center = lookfrom;
-
-                // determine viewport dimensions. 
-                auto theta = degrees_to_radians(vfov);
-                auto h = std::tan(theta * 0.5);
-                auto viewport_height = 2 * h * focus_dist;
-                auto viewport_width = viewport_height * (static_cast<double>(image_width) / image_height);
-
-                // build camera space
-                w = unit_vector(lookfrom - lookat);
-                u = unit_vector(cross(vup, w));
-                v = cross(w, u);
-
-                auto viewport_u = viewport_width * u;
-                auto viewport_v = viewport_height * -v;
-
-                pixel_delta_u = viewport_u / image_width;
-                pixel_delta_v = viewport_v / image_height;
-
-                // location of the upper left pixel
-                auto viewport_upper_left = center - focus_dist * w - viewport_u / 2 - viewport_v / 2;
-                pixel00_loc = viewport_upper_left + 0.5 * (pixel_delta_u + pixel_delta_v);
-
-                // camera defocus disk basis vectors
-                auto defocus_radius = focus_dist * std::tan(degrees_to_radians(defocus_angle));
-                defocus_disk_u = u * defocus_radius;
-                defocus_disk_v = v * defocus_radius;
-            }
-
-            ray get_ray(int i, int j, int s_i, int s_j) const {
-                // construct a camera ray originating from the defocus disk and directed at a random sampled point around the pixel location i,j
-                auto offset = sample_square_stratified(s_i, s_j);
-                auto pixel_sample = pixel00_loc + (i + offset.x()) * pixel_delta_u + (j + offset.y()) * pixel_delta_v;
-
-                auto ray_origin = (defocus_angle <= 0) ? center : defocus_disk_sample();
-                auto ray_direction = pixel_sample - ray_origin;
-                auto ray_time = random_double();
-
-                return ray(ray_origin, ray_direction, ray_time);
-            }
-
-            vec3 sample_square_stratified(int s_i, int s_j) const {
-                auto px = ((s_i + random_double()) * recip_sqrt_spp) - 0.5;
-                auto py = ((s_j + random_double()) * recip_sqrt_spp) - 0.5;
-
-                return vec3(px, py, 0);
-            }
-
-            vec3 sample_square() const {
-                return vec3(random_double() - 0.5, random_double() - 0.5, 0);
-            }
-
-            point3 defocus_disk_sample() const {
-                auto p = random_in_uint_disk();
-                return center + (p[0] * defocus_disk_u) + (p[1] * defocus_disk_v);
-            }
-
-            color ray_color(const ray& r, int depth, const hittable& world) const {
-                if (depth <= 0)
-                    return color(0, 0, 0);
-
-                hit_record rec;
-
-                // 0.001 for shadow acne, because of floating point rounding errors
-                if (!world.hit(r, interval(0.001, infinity), rec))
-                    return background;
-
-                ray scattered;
-                color attenuation;
-                color color_from_emission = rec.mat->emitted(rec.u, rec.v, rec.p);
-
-                if (!rec.mat->scatter(r, rec, attenuation, scattered))
-                    return color_from_emission;
-
-                color color_from_scatter = attenuation * ray_color(scattered, depth - 1, world);
-
-                return color_from_emission + color_from_scatter;
-            }
-    };
+#pragma once
+
+#include "hittable.h"
+#include "accumulation_buffer.h"
+#include "color.h"
+#include "framebuffer.h"
+#include "lights.h"
+#include "material.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace My {
+    // recursive is the book's ray_color, iterative the loop with russian roulette
+    enum class integrator_type { recursive, iterative };
+
+    // why a path stopped
+    enum class path_end { miss, absorbed, roulette, max_depth, count };
+
+    // path statistics of a render. length counts the rays traced along a path, camera ray included
+    struct path_stats
+    {
+        uint64_t rays = 0;
+        uint64_t paths = 0;
+        uint64_t ended[static_cast<int>(path_end::count)] = {};
+        std::vector<uint64_t> length_histogram;
+
+        void end_path(int length, path_end reason) {
+            paths++;
+            rays += length;
+            ended[static_cast<int>(reason)]++;
+            if (length >= static_cast<int>(length_histogram.size()))
+                length_histogram.resize(length + 1);
+            length_histogram[length]++;
+        }
+
+        void merge(const path_stats& other) {
+            rays += other.rays;
+            paths += other.paths;
+            for (int i = 0; i < static_cast<int>(path_end::count); i++)
+                ended[i] += other.ended[i];
+            if (other.length_histogram.size() > length_histogram.size())
+                length_histogram.resize(other.length_histogram.size());
+            for (size_t i = 0; i < other.length_histogram.size(); i++)
+                length_histogram[i] += other.length_histogram[i];
+        }
+
+        double mean_length() const { return paths > 0 ? static_cast<double>(rays) / paths : 0.0; }
+    };
+
+    class camera {
+        public:
+            double aspect_ratio = 1.0;
+            int image_width = 100;
+            int samples_per_pixel = 10;     // count of random samples for each pixel, rounded down to a square when stratified
+            int max_depth = 10;             // maximum number of ray bounces into scene
+            color background = color(0, 0, 0);
+
+            double vfov = 90;
+            // camera space
+            point3 lookfrom = point3(0, 0, 0);
+            point3 lookat = point3(0, 0, -1);
+            vec3 vup = vec3(0, 1, 0);
+
+            double defocus_angle = 0;       // variation angle of rays through each pixel
+            double focus_dist = 10;         // distance from camera lookfrom point to plane of perfect focus
+
+            int thread_count = 0;           // render worker threads, 0 uses every hardware thread
+            int tile_size = 16;             // edge length in pixels of the square tiles handed to the workers
+            uint64_t seed = 0;              // sampler seed, the image is a pure function of the scene and this seed
+            sampler_type sampling = sampler_type::sobol;
+
+            integrator_type integrator = integrator_type::iterative;
+            int rr_min_depth = 3;           // bounces before russian roulette may end a path, >= max_depth turns it off
+            bool next_event = true;         // iterative only: sample the registered lights at diffuse hits, combined by mis
+            int pass_spp = 16;              // progressive only: samples per pixel of one pass, rounded down to a square when stratified
+            double adaptive_threshold = 0;  // progressive only: stop sampling pixels whose relative error is below this, 0 samples all
+            int adaptive_min_passes = 2;    // passes every pixel gets before its error is trusted
+
+            const path_stats& last_stats() const { return stats; }
+
+            // with RT_COUNTERS, the counts of the last render, or of the passes of a progressive one so far
+            const render_counters& last_counters() const { return counters; }
+
+            int output_height() const { return std::max(1, static_cast<int>(image_width / aspect_ratio)); }
+
+            // renders tiles in parallel into a float framebuffer, writing it out is left to the caller (image_writer.h)
+            framebuffer render(const hittable& world, const material_table& materials, const light_list& lights) {
+                initialize();
+                reset_counters();
+
+                framebuffer image(image_width, image_height);
+
+                double seconds = for_each_tile([&](int x0, int y0, path_stats& tile_stats) {
+                    render_tile(world, materials, lights, x0, y0, 0, sample_count, sqrt_spp, nullptr, tile_stats,
+                                [&](size_t pixel_index, const color& sum, double) {
+                        image.set(pixel_index, pixel_samples_scale * sum);
+                    });
+                });
+
+                std::clog << "\rDone. " << workers << " threads, " << stats.rays << " rays in " << seconds
+                          << "s (" << (seconds > 0 ? stats.rays / seconds * 1e-6 : 0.0) << " Mrays/s)\n";
+                print_stats();
+                if (counters_enabled)
+                    print_counters();
+
+                return image;
+            }
+
+            // progressive rendering: pass k adds the samples [k * n, (k + 1) * n) of every pixel to accum, where n is
+            // pass_samples(); a stratified pass is stratified on its own. the samples of a pass do not depend on
+            // how many passes follow, so passes can be added to a resumed accumulation buffer without limit
+            void render_pass(const hittable& world, const material_table& materials, const light_list& lights,
+                             accumulation_buffer& accum) {
+                initialize();
+                // the footprint follows the pass, not samples_per_pixel, so raising --spp on resume keeps the
+                // passes already in the buffer and the ones still to come the same
+                int count = pass_samples();
+                differential_scale = footprint_scale(count);
+                if (accum.width() != image_width || accum.height() != image_height)
+                    accum = accumulation_buffer(image_width, image_height);
+                if (accum.passes() == 0 || pixel_costs.size() != accum.pixel_count())
+                    reset_counters();
+
+                uint32_t first_sample = accum.passes() * static_cast<uint32_t>(count);
+
+                // adaptive sampling decides from the buffer alone, so a resumed render skips the same pixels
+                std::vector<uint8_t> active;
+                size_t active_count = accum.pixel_count();
+                if (adaptive_threshold > 0 && static_cast<int>(accum.passes()) >= adaptive_min_passes)
+                    active = accum.active_pixels(adaptive_threshold, active_count);
+
+                double seconds = for_each_tile([&](int x0, int y0, path_stats& tile_stats) {
+                    render_tile(world, materials, lights, x0, y0, first_sample, count, pass_grid(), active.empty() ? nullptr : active.data(),
+                                tile_stats, [&](size_t pixel_index, const color& sum, double luminance_sq) {
+                        accum.add(pixel_index, sum, luminance_sq, count);
+                    });
+                });
+                accum.set_passes(accum.passes() + 1);
+
+                std::clog << "\rPass " << accum.passes() << ": " << count << " spp to " << active_count << " of "
+                          << accum.pixel_count() << " pixels, " << stats.rays << " rays in " << seconds << "s ("
+                          << (seconds > 0 ? stats.rays / seconds * 1e-6 : 0.0) << " Mrays/s)" << std::endl;
+            }
+
+            int pass_samples() const {
+                return sampling == sampler_type::stratified ? pass_grid() * pass_grid() : std::max(1, pass_spp);
+            }
+
+            // everything besides the pass count that changes the samples of a progressive render
+            uint64_t progressive_key() const {
+                uint64_t key = mix_bits(seed ^ 0x9e3779b97f4a7c15ULL);
+                auto mix_in = [&](uint64_t v) { key = mix_bits(key ^ v); };
+                mix_in(static_cast<uint64_t>(image_width));
+                mix_in(static_cast<uint64_t>(output_height()));
+                mix_in(static_cast<uint64_t>(max_depth));
+                mix_in(static_cast<uint64_t>(pass_samples()));
+                mix_in(static_cast<uint64_t>(sampling));
+                mix_in(static_cast<uint64_t>(integrator));
+                mix_in(static_cast<uint64_t>(rr_min_depth));
+                mix_in(next_event ? 1 : 0);
+                if (adaptive_threshold > 0) {
+                    uint64_t threshold_bits;
+                    std::memcpy(&threshold_bits, &adaptive_threshold, sizeof(threshold_bits));
+                    mix_in(threshold_bits);
+                    mix_in(static_cast<uint64_t>(adaptive_min_passes));
+                }
+                return key;
+            }
+
+            // totals per ray and per path, the rays and pixels by cost, and where the work went
+            void print_counters() const {
+                auto per = [](uint64_t n, uint64_t d) { return d > 0 ? static_cast<double>(n) / d : 0.0; };
+                std::clog << "Counters: " << counters.rays << " rays, per ray " << per(counters.node_visits, counters.rays)
+                          << " node visits, " << per(counters.box_tests, counters.rays) << " box tests, "
+                          << per(counters.primitive_tests, counters.rays) << " primitive tests ("
+                          << 100 * per(counters.primitive_hits, counters.primitive_tests) << "% hit); "
+                          << per(counters.scatters, counters.paths) << " scatters per path\n";
+
+                std::clog << "Rays by node visits and primitive tests:";
+                print_histogram(counters.ray_cost);
+
+                uint64_t pixels_by_cost[cost_buckets] = {};
+                for (size_t i = 0; i < pixel_costs.size(); i++) {
+                    if (pixel_samples[i] > 0)
+                        pixels_by_cost[cost_bucket(pixel_costs[i] / pixel_samples[i])]++;
+                }
+                std::clog << "Pixels by cost per sample:";
+                print_histogram(pixels_by_cost);
+                std::clog << "Most per sample: " << most_pixel_cost() << std::endl;
+            }
+
+            // node visits and primitive tests per sample of every pixel, relative to the most expensive pixel.
+            // black unless built with RT_COUNTERS
+            framebuffer cost_image() const {
+                framebuffer image(image_width, image_height);
+                double most = most_pixel_cost();
+                for (size_t i = 0; i < pixel_costs.size() && i < image.pixel_count(); i++) {
+                    double cost = pixel_samples[i] > 0 ? static_cast<double>(pixel_costs[i]) / pixel_samples[i] : 0.0;
+                    image.set(i, heatmap_color(most > 0 ? cost / most : 0.0));
+                }
+                return image;
+            }
+
+        private:
+            path_stats stats;
+            render_counters counters;
+            // with RT_COUNTERS, what each pixel's samples cost and how many there were; written by the tile
+            // that owns the pixel
+            mutable std::vector<uint64_t> pixel_costs;
+            mutable std::vector<uint32_t> pixel_samples;
+            int image_height;
+            double pixel_samples_scale;
+            int sample_count;               // samples per pixel actually taken
+            int sqrt_spp;
+            int workers = 1;                // threads of the last for_each_tile
+            // the render threads. copies of a camera share them, so only one of the copies renders at a time
+            std::shared_ptr<thread_pool> pool;
+            int pool_threads = 0;           // the thread_count pool was started with
+            point3 center;
+            point3 pixel00_loc;
+            vec3 pixel_delta_u;
+            vec3 pixel_delta_v;
+            vec3 u, v, w;                   // camera from basis vectors
+            vec3 defocus_disk_u;
+            vec3 defocus_disk_v;
+            double differential_scale;      // of the pixel step, for the texture footprint
+
+            // the samples of a pixel already average over its area, so each one filters textures over the
+            // share of the pixel it stands for (as in pbrt), and no less than an eighth of it
+            static double footprint_scale(int samples) {
+                return std::max(0.125, 1 / std::sqrt(static_cast<double>(samples)));
+            }
+
+            void initialize() {
+                image_height = output_height();
+
+                sqrt_spp = std::max(1, static_cast<int>(std::sqrt(samples_per_pixel)));
+                sample_count = sampling == sampler_type::stratified ? sqrt_spp * sqrt_spp : std::max(1, samples_per_pixel);
+                pixel_samples_scale = 1.0 / sample_count;
+                differential_scale = footprint_scale(sample_count);
+
+                center = lookfrom;
+
+                // determine viewport dimensions. 
+                auto theta = degrees_to_radians(vfov);
+                auto h = std::tan(theta * 0.5);
+                auto viewport_height = 2 * h * focus_dist;
+                auto viewport_width = viewport_height * (static_cast<double>(image_width) / image_height);
+
+                // build camera space
+                w = unit_vector(lookfrom - lookat);
+                u = unit_vector(cross(vup, w));
+                v = cross(w, u);
+
+                auto viewport_u = viewport_width * u;
+                auto viewport_v = viewport_height * -v;
+
+                pixel_delta_u = viewport_u / image_width;
+                pixel_delta_v = viewport_v / image_height;
+
+                // location of the upper left pixel
+                auto viewport_upper_left = center - focus_dist * w - viewport_u / 2 - viewport_v / 2;
+                pixel00_loc = viewport_upper_left + 0.5 * (pixel_delta_u + pixel_delta_v);
+
+                // camera defocus disk basis vectors
+                auto defocus_radius = focus_dist * std::tan(degrees_to_radians(defocus_angle));
+                defocus_disk_u = u * defocus_radius;
+                defocus_disk_v = v * defocus_radius;
+            }
+
+            int pass_grid() const { return std::max(1, static_cast<int>(std::sqrt(pass_spp))); }
+
+            void reset_counters() {
+                counters = render_counters();
+                if (counters_enabled) {
+                    pixel_costs.assign(static_cast<size_t>(image_width) * image_height, 0);
+                    pixel_samples.assign(pixel_costs.size(), 0);
+                }
+            }
+
+            double most_pixel_cost() const {
+                double most = 0;
+                for (size_t i = 0; i < pixel_costs.size(); i++) {
+                    if (pixel_samples[i] > 0)
+                        most = std::max(most, static_cast<double>(pixel_costs[i]) / pixel_samples[i]);
+                }
+                return most;
+            }
+
+            static void print_histogram(const uint64_t (&buckets)[cost_buckets]) {
+                for (int b = 0; b < cost_buckets; b++) {
+                    if (buckets[b] == 0)
+                        continue;
+                    std::clog << " ";
+                    if (b < 2)
+                        std::clog << b;
+                    else
+                        std::clog << (uint64_t(1) << (b - 1)) << "-" << ((uint64_t(1) << b) - 1);
+                    std::clog << ":" << buckets[b];
+                }
+                std::clog << "\n";
+            }
+
+            // runs fn(x0, y0, tile_stats) for every tile on the thread pool, collects the path statistics
+            // and returns the seconds taken
+            template <typename F>
+            double for_each_tile(F&& fn) {
+                int tiles_x = (image_width + tile_size - 1) / tile_size;
+                int tiles_y = (image_height + tile_size - 1) / tile_size;
+                int tile_count = tiles_x * tiles_y;
+
+                // the workers are started once and kept for every render and pass after, until thread_count changes
+                if (!pool || pool_threads != thread_count) {
+                    pool.reset();
+                    pool = std::make_shared<thread_pool>(thread_count);
+                    pool_threads = thread_count;
+                }
+                workers = pool->size();
+                std::atomic<int> tiles_remaining{tile_count};
+                std::mutex log_lock;
+                stats = path_stats();
+
+                auto start = std::chrono::steady_clock::now();
+
+                pool->parallel_for(tile_count, [&](int tile, int) {
+                    path_stats tile_stats;
+#ifdef RT_COUNTERS
+                    thread_counters() = render_counters();
+#endif
+                    fn((tile % tiles_x) * tile_size, (tile / tiles_x) * tile_size, tile_stats);
+
+                    int remaining = --tiles_remaining;
+                    std::lock_guard<std::mutex> guard(log_lock);
+                    stats.merge(tile_stats);
+#ifdef RT_COUNTERS
+                    counters.merge(thread_counters());
+#endif
+                    std::clog << "\rTiles remaining: " << remaining << "    " << std::flush;
+                });
+
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                return elapsed.count();
+            }
+
+            // render one tile, the samples [first_sample, first_sample + count) of each pixel, and hand every pixel's
+            // sum and sum of squared sample luminances to store. the stratified sampler puts the pixel offsets on a
+            // grid x grid stratification (count is grid * grid then). pixels with a zero in active (if given) are
+            // skipped. the random numbers of every sample are keyed on (pixel, sample), so the image is the same
+            // whatever the thread count or tile order
+            template <typename F>
+            void render_tile(const hittable& world, const material_table& materials, const light_list& lights,
+                             int x0, int y0, uint32_t first_sample, int count, int grid, const uint8_t* active,
+                             path_stats& tile_stats, F&& store) const {
+                sampler s(seed, sampling, static_cast<uint32_t>(count));
+                int x1 = std::min(x0 + tile_size, image_width);
+                int y1 = std::min(y0 + tile_size, image_height);
+                double recip_grid = 1.0 / grid;
+
+                for (int j = y0; j < y1; j++) {
+                    for (int i = x0; i < x1; i++) {
+                        auto pixel_index = static_cast<size_t>(j) * image_width + i;
+                        if (active && !active[pixel_index])
+                            continue;
+
+#ifdef RT_COUNTERS
+                        uint64_t pixel_start = thread_counters().cost();
+#endif
+                        color pixel_color(0, 0, 0);
+                        double luminance_sq = 0;
+                        for (int k = 0; k < count; k++) {
+                            s.start_pixel_sample(static_cast<uint32_t>(pixel_index), first_sample + k);
+                            RT_COUNT(paths);
+                            ray r = get_ray(i, j, k % grid, k / grid, recip_grid, s);
+                            ray_differential differential = get_differential(r);
+                            color sample;
+                            if (integrator == integrator_type::iterative) {
+                                sample = trace_path(r, world, materials, lights, s, tile_stats, &differential);
+                            } else {
+                                int length = 0;
+                                path_end reason;
+                                sample = ray_color(r, max_depth, world, materials, s, length, reason, &differential);
+                                tile_stats.end_path(length, reason);
+                            }
+                            pixel_color += sample;
+                            double y = luminance(sample);
+                            luminance_sq += y * y;
+                        }
+
+#ifdef RT_COUNTERS
+                        pixel_costs[pixel_index] += thread_counters().cost() - pixel_start;
+                        pixel_samples[pixel_index] += static_cast<uint32_t>(count);
+#endif
+                        store(pixel_index, pixel_color, luminance_sq);
+                    }
+                }
+            }
+
+            ray get_ray(int i, int j, int s_i, int s_j, double recip_grid, sampler& s) const {
+                // construct a camera ray originating from the defocus disk and directed at a random sampled point around the pixel location i,j.
+                // the pixel offset takes the first two dimensions, then the lens and the time
+                auto offset = s.kind() == sampler_type::stratified ? sample_square_stratified(s_i, s_j, recip_grid, s) : sample_square(s);
+                auto pixel_sample = pixel00_loc + (i + offset.x()) * pixel_delta_u + (j + offset.y()) * pixel_delta_v;
+
+                auto ray_origin = (defocus_angle <= 0) ? center : defocus_disk_sample(s);
+                auto ray_direction = pixel_sample - ray_origin;
+                auto ray_time = s.get_1d();
+
+                return ray(ray_origin, ray_direction, ray_time);
+            }
+
+            // rays from the same lens point through points offset by the pixel step, scaled to a sample's share
+            ray_differential get_differential(const ray& r) const {
+                return { r.origin(), r.origin(), r.direction() + differential_scale * pixel_delta_u,
+                         r.direction() + differential_scale * pixel_delta_v };
+            }
+
+            vec3 sample_square_stratified(int s_i, int s_j, double recip_grid, sampler& s) const {
+                auto px = ((s_i + s.get_1d()) * recip_grid) - 0.5;
+                auto py = ((s_j + s.get_1d()) * recip_grid) - 0.5;
+
+                return vec3(px, py, 0);
+            }
+
+            vec3 sample_square(sampler& s) const {
+                auto px = s.get_1d() - 0.5;
+                auto py = s.get_1d() - 0.5;
+                return vec3(px, py, 0);
+            }
+
+            point3 defocus_disk_sample(sampler& s) const {
+                auto p = random_in_uint_disk(s);
+                return center + (p[0] * defocus_disk_u) + (p[1] * defocus_disk_v);
+            }
+
+            // differential, if given, belongs to r and sets the texture footprint of the first hit
+            color ray_color(const ray& r, int depth, const hittable& world, const material_table& materials,
+                            sampler& s, int& length, path_end& reason, const ray_differential* differential = nullptr) const {
+                if (depth <= 0) {
+                    reason = path_end::max_depth;
+                    return color(0, 0, 0);
+                }
+
+                length++;
+                s.start_bounce(max_depth - depth);
+                hit_record rec;
+
+                // rays start off their surface (hit_record::spawn_ray), so no minimum distance against shadow acne
+                if (!RT_COUNT_RAY(world.hit(r, interval(0, infinity), rec, s))) {
+                    reason = path_end::miss;
+                    return background;
+                }
+                rec.finish_surface(r);
+                if (differential)
+                    rec.set_footprint(*differential);
+
+                ray scattered;
+                color attenuation;
+                color color_from_emission = materials.emitted(rec);
+
+                if (!materials.scatter(r, rec, attenuation, scattered, s)) {
+                    reason = path_end::absorbed;
+                    return color_from_emission;
+                }
+                RT_COUNT(scatters);
+
+                color color_from_scatter = attenuation * ray_color(scattered, depth - 1, world, materials, s, length, reason);
+
+                return color_from_emission + color_from_scatter;
+            }
+
+            // same estimator as ray_color as a loop carrying the path throughput. once rr_min_depth bounces are done,
+            // a path survives with probability max(throughput) and is reweighted by its inverse, which keeps the
+            // estimate unbiased while dark paths end early.
+            // with next_event, every diffuse hit also samples a light directly; emission found by the bsdf sample
+            // after a diffuse hit is then weighted against that with the power heuristic
+            // differential, if given, belongs to the camera ray and sets the texture footprint of the first hit;
+            // later bounces look textures up at full resolution
+            color trace_path(ray r, const hittable& world, const material_table& materials, const light_list& lights,
+                             sampler& s, path_stats& path, const ray_differential* differential = nullptr) const {
+                color radiance(0, 0, 0);
+                color throughput(1, 1, 1);
+                bool sample_lights = next_event && !lights.empty();
+                double bsdf_pdf = 0;        // density of the direction that led to this hit, 0 after a delta bounce
+                point3 bsdf_origin;
+
+                for (int depth = 0; ; ) {
+                    if (depth >= max_depth) {
+                        path.end_path(depth, path_end::max_depth);
+                        break;
+                    }
+
+                    s.start_bounce(depth);
+                    hit_record rec;
+
+                    if (!RT_COUNT_RAY(world.hit(r, interval(0, infinity), rec, s))) {
+                        radiance += throughput * background;
+                        path.end_path(depth + 1, path_end::miss);
+                        break;
+                    }
+                    rec.finish_surface(r);
+                    if (depth == 0 && differential)
+                        rec.set_footprint(*differential);
+
+                    color emission = materials.emitted(rec);
+                    if (bsdf_pdf > 0 && materials.is_emissive(rec.mat))
+                        emission *= power_heuristic(bsdf_pdf, lights.pdf(bsdf_origin, r.direction(), r.time()));
+                    radiance += throughput * emission;
+
+                    // not at the last vertex: the bsdf sample it is weighted against would never be traced
+                    bool diffuse = sample_lights && depth + 1 < max_depth && materials.is_diffuse(rec.mat);
+                    if (diffuse)
+                        radiance += throughput * sample_light(r, rec, world, materials, lights, s);
+
+                    ray scattered;
+                    color attenuation;
+                    if (!materials.scatter(r, rec, attenuation, scattered, s)) {
+                        path.end_path(depth + 1, path_end::absorbed);
+                        break;
+                    }
+                    RT_COUNT(scatters);
+
+                    bsdf_pdf = diffuse ? materials.pdf(r, rec, scattered.direction()) : 0;
+                    bsdf_origin = rec.p;
+
+                    throughput = throughput * attenuation;
+                    depth++;
+
+                    if (depth >= rr_min_depth && depth < max_depth) {
+                        double survive = std::min<double>(1.0, std::max(throughput.x(), std::max(throughput.y(), throughput.z())));
+                        if (s.get_1d() >= survive) {
+                            path.end_path(depth, path_end::roulette);
+                            break;
+                        }
+                        throughput /= survive;
+                    }
+
+                    r = scattered;
+                }
+
+                return radiance;
+            }
+
+            // direct light from one light sample, mis weighted against the bsdf sample of the same hit
+            color sample_light(const ray& r, const hit_record& rec, const hittable& world, const material_table& materials,
+                               const light_list& lights, sampler& s) const {
+                light_sample ls;
+                if (!lights.sample(rec.p, r.time(), materials, s, ls))
+                    return color(0, 0, 0);
+
+                color f = materials.eval(r, rec, ls.direction);
+                if (f.length_squared() == 0 || ls.radiance.length_squared() == 0)
+                    return color(0, 0, 0);
+
+                // the ray ends a little short of the light, which is rounded like any other surface and would block it
+                ray shadow = rec.spawn_ray_to(rec.p + ls.distance * ls.direction, r.time());
+                if (RT_COUNT_RAY(world.occluded(shadow, interval(0, 1 - 1e-4), s)))
+                    return color(0, 0, 0);
+
+                double weight = power_heuristic(ls.pdf, materials.pdf(r, rec, ls.direction));
+                return f * ls.radiance * (weight / ls.pdf);
+            }
+
+            void print_stats() const {
+                const char* names[] = { "miss", "absorbed", "roulette", "max depth" };
+                std::clog << "Paths: " << stats.paths << ", mean length " << stats.mean_length() << ", ended by";
+                for (int i = 0; i < static_cast<int>(path_end::count); i++) {
+                    double share = stats.paths > 0 ? 100.0 * stats.ended[i] / stats.paths : 0.0;
+                    std::clog << (i > 0 ? ", " : " ") << names[i] << " " << share << "%";
+                }
+                std::clog << "\nPath lengths:";
+                for (size_t i = 0; i < stats.length_histogram.size(); i++) {
+                    if (stats.length_histogram[i] > 0)
+                        std::clog << " " << i << ":" << stats.length_histogram[i];
+                }
+                std::clog << std::endl;
+            }
+    };
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "accumulation_buffer.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace My
+{
+    // checkpoint file: this header, the float rgb sums, the sums of squared luminance, then the per-pixel sample counts.
+    // key identifies the render settings the sums belong to, a resume with other settings is refused
+    struct checkpoint_header
+    {
+        char magic[8];
+        uint64_t key;
+        uint32_t width;
+        uint32_t height;
+        uint32_t passes;
+        uint32_t pad;
+    };
+
+    inline const char* checkpoint_magic() { return "RTACCUM2"; }
+
+    inline size_t checkpoint_size(const accumulation_buffer& accum) {
+        return sizeof(checkpoint_header) + accum.pixel_count() * (4 * sizeof(float) + sizeof(uint32_t));
+    }
+
+    // written to a temporary file that then replaces path, so an interrupted save keeps the last checkpoint
+    inline bool save_checkpoint(const std::string& path, uint64_t key, const accumulation_buffer& accum) {
+        std::string temp_path = path + ".tmp";
+        {
+            mapped_file file;
+            if (!file.create(temp_path, checkpoint_size(accum))) {
+                std::cerr << "ERROR: could not create checkpoint '" << temp_path << "'.\n";
+                return false;
+            }
+
+            checkpoint_header header = {};
+            std::memcpy(header.magic, checkpoint_magic(), sizeof(header.magic));
+            header.key = key;
+            header.width = static_cast<uint32_t>(accum.width());
+            header.height = static_cast<uint32_t>(accum.height());
+            header.passes = accum.passes();
+
+            char* p = file.data();
+            std::memcpy(p, &header, sizeof(header));
+            p += sizeof(header);
+            std::memcpy(p, accum.sum_data(), accum.pixel_count() * 3 * sizeof(float));
+            p += accum.pixel_count() * 3 * sizeof(float);
+            std::memcpy(p, accum.luminance_sq_data(), accum.pixel_count() * sizeof(float));
+            p += accum.pixel_count() * sizeof(float);
+            std::memcpy(p, accum.count_data(), accum.pixel_count() * sizeof(uint32_t));
+
+            if (!file.flush()) {
+                std::cerr << "ERROR: could not write checkpoint '" << temp_path << "'.\n";
+                return false;
+            }
+        }
+
+        if (!replace_file(temp_path, path)) {
+            std::cerr << "ERROR: could not replace checkpoint '" << path << "'.\n";
+            return false;
+        }
+        return true;
+    }
+
+    enum class checkpoint_status { missing, loaded, rejected };
+
+    // accum is only touched when the checkpoint is loaded
+    inline checkpoint_status load_checkpoint(const std::string& path, uint64_t key, int width, int height, accumulation_buffer& accum) {
+        mapped_file file;
+        if (!file.open(path))
+            return checkpoint_status::missing;
+
+        checkpoint_header header;
+        if (file.size() < sizeof(header) || std::memcmp(file.data(), checkpoint_magic(), sizeof(header.magic)) != 0) {
+            std::cerr << "ERROR: '" << path << "' is not a checkpoint.\n";
+            return checkpoint_status::rejected;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        if (header.key != key || header.width != static_cast<uint32_t>(width) || header.height != static_cast<uint32_t>(height)) {
+            std::cerr << "ERROR: checkpoint '" << path << "' was rendered with other settings.\n";
+            return checkpoint_status::rejected;
+        }
+
+        accumulation_buffer loaded(width, height);
+        if (file.size() != checkpoint_size(loaded)) {
+            std::cerr << "ERROR: checkpoint '" << path << "' is truncated.\n";
+            return checkpoint_status::rejected;
+        }
+
+        const char* p = file.data() + sizeof(header);
+        std::memcpy(loaded.sum_data(), p, loaded.pixel_count() * 3 * sizeof(float));
+        p += loaded.pixel_count() * 3 * sizeof(float);
+        std::memcpy(loaded.luminance_sq_data(), p, loaded.pixel_count() * sizeof(float));
+        p += loaded.pixel_count() * sizeof(float);
+        std::memcpy(loaded.count_data(), p, loaded.pixel_count() * sizeof(uint32_t));
+        loaded.set_passes(header.passes);
+
+        accum = std::move(loaded);
+        return checkpoint_status::loaded;
+    }
+}
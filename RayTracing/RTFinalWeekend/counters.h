@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+// what the rays of a render cost, for telling a poor bvh from too many primitives or long paths.
+// the counters only exist when built with RT_COUNTERS (cmake -DRT_COUNTERS=ON); otherwise every macro below
+// expands to nothing, or to the bare expression it wraps, and the renderer is the same as without them
+#ifdef RT_COUNTERS
+#define RT_COUNT(counter) (++::My::thread_counters().counter)
+#define RT_COUNT_N(counter, n) (::My::thread_counters().counter += (n))
+#define RT_COUNT_HIT(test) ::My::count_hit(test)
+#define RT_COUNT_RAY(query) ::My::count_ray([&] { return (query); })
+#else
+#define RT_COUNT(counter) ((void)0)
+#define RT_COUNT_N(counter, n) ((void)0)
+#define RT_COUNT_HIT(test) (test)
+#define RT_COUNT_RAY(query) (query)
+#endif
+
+namespace My
+{
+#ifdef RT_COUNTERS
+    constexpr bool counters_enabled = true;
+#else
+    constexpr bool counters_enabled = false;
+#endif
+
+    // histogram buckets by powers of two: 0 holds zero, b holds [2^(b-1), 2^b), the last one everything above
+    constexpr int cost_buckets = 24;
+
+    inline int cost_bucket(uint64_t value) {
+        int b = 0;
+        while (value > 0 && b < cost_buckets - 1) {
+            b++;
+            value >>= 1;
+        }
+        return b;
+    }
+
+    // one thread's counts. the camera zeroes them when a worker starts a tile and adds them to the render's
+    // totals when it is done, so a thread never shares its counters
+    struct render_counters
+    {
+        uint64_t paths = 0;             // camera samples
+        uint64_t rays = 0;              // closest hit and shadow queries the camera made
+        uint64_t node_visits = 0;       // bvh nodes a traversal fetched
+        uint64_t box_tests = 0;         // ray against bounding box tests, four for a bvh4 node
+        uint64_t primitive_tests = 0;   // ray against sphere, quad or triangle tests
+        uint64_t primitive_hits = 0;    // of those, the ones that found an intersection in the ray's interval
+        uint64_t scatters = 0;          // bounces a material scattered
+        uint64_t ray_cost[cost_buckets] = {};   // rays by their node visits plus primitive tests
+
+        // what a ray's cost is made of
+        uint64_t cost() const { return node_visits + primitive_tests; }
+
+        void merge(const render_counters& other) {
+            paths += other.paths;
+            rays += other.rays;
+            node_visits += other.node_visits;
+            box_tests += other.box_tests;
+            primitive_tests += other.primitive_tests;
+            primitive_hits += other.primitive_hits;
+            scatters += other.scatters;
+            for (int b = 0; b < cost_buckets; b++)
+                ray_cost[b] += other.ray_cost[b];
+        }
+    };
+
+    // constant initialized, so the access compiles to a thread pointer offset without a guard
+    inline render_counters& thread_counters() {
+        thread_local render_counters counters;
+        return counters;
+    }
+
+    inline bool count_hit(bool hit) {
+        if (hit)
+            thread_counters().primitive_hits++;
+        return hit;
+    }
+
+    // runs one query of the camera and files it under its cost
+    template <typename F>
+    bool count_ray(F&& query) {
+        render_counters& c = thread_counters();
+        uint64_t start = c.cost();
+        bool result = query();
+        c.rays++;
+        c.ray_cost[cost_bucket(c.cost() - start)]++;
+        return result;
+    }
+}
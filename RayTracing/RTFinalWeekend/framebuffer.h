@@ -0,0 +1,49 @@
+#pragma once
+
+#include "color.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace My
+{
+    // linear rgb image in float, three values per pixel, rows top to bottom
+    class framebuffer
+    {
+    public:
+        framebuffer() : image_width(0), image_height(0) {}
+        framebuffer(int width, int height)
+            : image_width(width), image_height(height), pixels(static_cast<size_t>(width) * height * 3, 0.0f) {}
+
+        int width() const { return image_width; }
+        int height() const { return image_height; }
+        size_t pixel_count() const { return static_cast<size_t>(image_width) * image_height; }
+
+        void set(size_t pixel_index, const color& c) {
+            float* p = &pixels[pixel_index * 3];
+            p[0] = static_cast<float>(c.x());
+            p[1] = static_cast<float>(c.y());
+            p[2] = static_cast<float>(c.z());
+        }
+
+        color get(size_t pixel_index) const {
+            const float* p = &pixels[pixel_index * 3];
+            return color(p[0], p[1], p[2]);
+        }
+
+        const float* data() const { return pixels.data(); }
+        float* data() { return pixels.data(); }
+
+    private:
+        int image_width;
+        int image_height;
+        std::vector<float> pixels;
+    };
+
+    // t from 0 to 1 as black through red and yellow to white, squared since the image writers apply gamma 2
+    inline color heatmap_color(double t) {
+        color c(std::min(1.0, 3 * t), std::clamp(3 * t - 1, 0.0, 1.0), std::clamp(3 * t - 2, 0.0, 1.0));
+        return c * c;
+    }
+}
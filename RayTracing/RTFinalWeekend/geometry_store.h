@@ -0,0 +1,449 @@
+#pragma once
+#include "aabb.h"
+#include "bvh_builder.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "quad.h"
+#include "sphere.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <typeinfo>
+#include <vector>
+
+namespace My
+{
+    // spheres as structure of arrays. a stationary sphere has zero velocity
+    struct sphere_soa
+    {
+        std::vector<double> center_x, center_y, center_z;
+        std::vector<double> velocity_x, velocity_y, velocity_z;
+        std::vector<double> radius;
+        std::vector<material_id> materials;
+
+        size_t size() const { return radius.size(); }
+
+        void push_back(const point3& center, const vec3& velocity, double r, material_id mat) {
+            center_x.push_back(center.x()); center_y.push_back(center.y()); center_z.push_back(center.z());
+            velocity_x.push_back(velocity.x()); velocity_y.push_back(velocity.y()); velocity_z.push_back(velocity.z());
+            radius.push_back(r);
+            materials.push_back(mat);
+        }
+
+        point3 center(size_t i, double time) const {
+            return point3(center_x[i] + time * velocity_x[i], center_y[i] + time * velocity_y[i], center_z[i] + time * velocity_z[i]);
+        }
+    };
+
+    // quads as structure of arrays, with the plane (normal, D) and w = n / dot(n, n) precomputed
+    struct quad_soa
+    {
+        std::vector<double> q_x, q_y, q_z;
+        std::vector<double> u_x, u_y, u_z;
+        std::vector<double> v_x, v_y, v_z;
+        std::vector<double> w_x, w_y, w_z;
+        std::vector<double> normal_x, normal_y, normal_z;
+        std::vector<double> d;
+        std::vector<material_id> materials;
+
+        size_t size() const { return d.size(); }
+
+        void push_back(const point3& Q, const vec3& u, const vec3& v, const vec3& w, const vec3& normal, double D, material_id mat) {
+            q_x.push_back(Q.x()); q_y.push_back(Q.y()); q_z.push_back(Q.z());
+            u_x.push_back(u.x()); u_y.push_back(u.y()); u_z.push_back(u.z());
+            v_x.push_back(v.x()); v_y.push_back(v.y()); v_z.push_back(v.z());
+            w_x.push_back(w.x()); w_y.push_back(w.y()); w_z.push_back(w.z());
+            normal_x.push_back(normal.x()); normal_y.push_back(normal.y()); normal_z.push_back(normal.z());
+            d.push_back(D);
+            materials.push_back(mat);
+        }
+    };
+
+    // spheres and quads kept in flat arrays instead of one heap object each, under a single sah bvh.
+    // a leaf covers a contiguous range of each array, tested in a tight loop without virtual calls.
+    // anything else (constant_medium, translate, rotate_y, nested accelerators) stays a hittable on the slow path
+    class geometry_store : public hittable
+    {
+    public:
+        void add_sphere(const point3& center, double radius, material_id mat) {
+            add_moving_sphere(center, center, radius, mat);
+        }
+
+        void add_moving_sphere(const point3& center1, const point3& center2, double radius, material_id mat) {
+            refs.push_back({ primitive_kind::sphere, static_cast<uint32_t>(pending_spheres.size()) });
+            pending_spheres.push_back(center1, center2 - center1, std::fmax(0, radius), mat);
+        }
+
+        void add_quad(const point3& Q, const vec3& u, const vec3& v, material_id mat) {
+            auto n = cross(u, v);
+            auto normal = unit_vector(n);
+            refs.push_back({ primitive_kind::quad, static_cast<uint32_t>(pending_quads.size()) });
+            pending_quads.push_back(Q, u, v, n / dot(n, n), normal, dot(normal, Q), mat);
+        }
+
+        void add_object(const shared_ptr<hittable>& object) {
+            refs.push_back({ primitive_kind::object, static_cast<uint32_t>(pending_objects.size()) });
+            pending_objects.push_back(object);
+        }
+
+        // moves plain spheres and quads into the arrays and flattens nested lists; other hittables
+        // (and subclasses of quad, which may override is_interior) are kept as objects
+        void add(const shared_ptr<hittable>& object) {
+            const auto& type = typeid(*object);
+            if (type == typeid(sphere)) {
+                const auto& sp = static_cast<const sphere&>(*object);
+                refs.push_back({ primitive_kind::sphere, static_cast<uint32_t>(pending_spheres.size()) });
+                pending_spheres.push_back(sp.center.origin(), sp.center.direction(), sp.radius, sp.mat);
+            } else if (type == typeid(quad)) {
+                const auto& qd = static_cast<const quad&>(*object);
+                refs.push_back({ primitive_kind::quad, static_cast<uint32_t>(pending_quads.size()) });
+                pending_quads.push_back(qd.Q, qd.u, qd.v, qd.w, qd.normal, qd.D, qd.mat);
+            } else if (type == typeid(hittable_list)) {
+                add(static_cast<const hittable_list&>(*object));
+            } else {
+                add_object(object);
+            }
+        }
+
+        void add(const hittable_list& list) {
+            for (const auto& object : list.objects)
+                add(object);
+        }
+
+        // builds the bvh and lays the arrays out in leaf order. the store is read-only afterwards
+        void build(const bvh_builder& builder = bvh_builder()) {
+            std::vector<aabb> bounds;
+            bounds.reserve(refs.size());
+            for (const auto& ref : refs)
+                bounds.push_back(primitive_bounds(ref));
+
+            std::vector<uint32_t> order;
+            nodes = builder.build(bounds, order, &stats);
+
+            spheres = sphere_soa();
+            quads = quad_soa();
+            objects.clear();
+            leaves.clear();
+            bbox = aabb::empty;
+            for (const auto& box : bounds)
+                bbox = aabb(bbox, box);
+
+            for (auto& node : nodes) {
+                if (!node.is_leaf())
+                    continue;
+
+                leaf_range leaf;
+                leaf.sphere_begin = static_cast<uint32_t>(spheres.size());
+                leaf.quad_begin = static_cast<uint32_t>(quads.size());
+                leaf.object_begin = static_cast<uint32_t>(objects.size());
+                for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                    append(refs[order[i]]);
+                leaf.sphere_end = static_cast<uint32_t>(spheres.size());
+                leaf.quad_end = static_cast<uint32_t>(quads.size());
+                leaf.object_end = static_cast<uint32_t>(objects.size());
+
+                node.offset = static_cast<uint32_t>(leaves.size());
+                leaves.push_back(leaf);
+            }
+
+            refs.clear();
+            pending_spheres = sphere_soa();
+            pending_quads = quad_soa();
+            pending_objects.clear();
+        }
+
+        bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            const point3& origin = r.origin();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            bool hit_anything = false;
+
+            traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const linear_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, ray_t.min, ray_t.max); },
+                [&](const linear_bvh_node& node) {
+                    if (hit_leaf(leaves[node.offset], r, ray_t, rec, s))
+                        hit_anything = true;
+                    return false;
+                });
+
+            return hit_anything;
+        }
+
+        bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            const point3& origin = r.origin();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            return traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const linear_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, ray_t.min, ray_t.max); },
+                [&](const linear_bvh_node& node) {
+                    return occluded_leaf(leaves[node.offset], r, ray_t, s);
+                });
+        }
+
+        aabb bounding_box() const override { return bbox; }
+
+        void set_surface(const ray& r, hit_record& rec) const override {
+            if (rec.primitive & quad_bit)
+                set_quad_record(rec.primitive & ~quad_bit, r, rec);
+            else
+                set_sphere_record(rec.primitive, r, rec);
+        }
+
+        size_t sphere_count() const { return spheres.size(); }
+        size_t quad_count() const { return quads.size(); }
+        size_t object_count() const { return objects.size(); }
+
+        const bvh_build_stats& build_stats() const { return stats; }
+
+    private:
+        // primitives are tested in batches so the arithmetic of one batch runs without branches
+        static constexpr int batch_size = 8;
+
+        // marks a quad index in hit_record::primitive, sphere indices are stored as is
+        static constexpr uint32_t quad_bit = 1u << 31;
+
+        enum class primitive_kind : uint8_t { sphere, quad, object };
+
+        struct primitive_ref {
+            primitive_kind kind;
+            uint32_t index;
+        };
+
+        struct leaf_range {
+            uint32_t sphere_begin, sphere_end;
+            uint32_t quad_begin, quad_end;
+            uint32_t object_begin, object_end;
+        };
+
+        std::vector<linear_bvh_node> nodes;
+        std::vector<leaf_range> leaves;
+        sphere_soa spheres;
+        quad_soa quads;
+        std::vector<shared_ptr<hittable>> objects;
+        aabb bbox;
+        bvh_build_stats stats;
+
+        // primitives added since the last build, in insertion order
+        std::vector<primitive_ref> refs;
+        sphere_soa pending_spheres;
+        quad_soa pending_quads;
+        std::vector<shared_ptr<hittable>> pending_objects;
+
+        aabb primitive_bounds(const primitive_ref& ref) const {
+            if (ref.kind == primitive_kind::sphere) {
+                auto rvec = vec3(pending_spheres.radius[ref.index], pending_spheres.radius[ref.index], pending_spheres.radius[ref.index]);
+                auto c0 = pending_spheres.center(ref.index, 0);
+                auto c1 = pending_spheres.center(ref.index, 1);
+                return aabb(aabb(c0 - rvec, c0 + rvec), aabb(c1 - rvec, c1 + rvec));
+            }
+            if (ref.kind == primitive_kind::quad) {
+                point3 Q(pending_quads.q_x[ref.index], pending_quads.q_y[ref.index], pending_quads.q_z[ref.index]);
+                vec3 u(pending_quads.u_x[ref.index], pending_quads.u_y[ref.index], pending_quads.u_z[ref.index]);
+                vec3 v(pending_quads.v_x[ref.index], pending_quads.v_y[ref.index], pending_quads.v_z[ref.index]);
+                return aabb(aabb(Q, Q + u + v), aabb(Q + u, Q + v));
+            }
+            return pending_objects[ref.index]->bounding_box();
+        }
+
+        void append(const primitive_ref& ref) {
+            uint32_t i = ref.index;
+            if (ref.kind == primitive_kind::sphere) {
+                const auto& p = pending_spheres;
+                spheres.push_back(point3(p.center_x[i], p.center_y[i], p.center_z[i]),
+                                  vec3(p.velocity_x[i], p.velocity_y[i], p.velocity_z[i]), p.radius[i], p.materials[i]);
+            } else if (ref.kind == primitive_kind::quad) {
+                const auto& p = pending_quads;
+                quads.push_back(point3(p.q_x[i], p.q_y[i], p.q_z[i]), vec3(p.u_x[i], p.u_y[i], p.u_z[i]),
+                                vec3(p.v_x[i], p.v_y[i], p.v_z[i]), vec3(p.w_x[i], p.w_y[i], p.w_z[i]),
+                                vec3(p.normal_x[i], p.normal_y[i], p.normal_z[i]), p.d[i], p.materials[i]);
+            } else {
+                objects.push_back(pending_objects[i]);
+            }
+        }
+
+        bool hit_leaf(const leaf_range& leaf, const ray& r, interval& ray_t, hit_record& rec, sampler& s) const {
+            bool hit_anything = false;
+
+            if (leaf.sphere_begin < leaf.sphere_end) {
+                uint32_t index = 0;
+                double t = 0;
+                if (closest_sphere(leaf.sphere_begin, leaf.sphere_end, r, ray_t, index, t)) {
+                    ray_t.max = t;
+                    rec.t = t;
+                    rec.surface = this;
+                    rec.primitive = index;
+                    hit_anything = true;
+                }
+            }
+
+            if (leaf.quad_begin < leaf.quad_end) {
+                uint32_t index = 0;
+                double t = 0, alpha = 0, beta = 0;
+                if (closest_quad(leaf.quad_begin, leaf.quad_end, r, ray_t, index, t, alpha, beta)) {
+                    ray_t.max = t;
+                    rec.t = t;
+                    rec.u = alpha;
+                    rec.v = beta;
+                    rec.surface = this;
+                    rec.primitive = index | quad_bit;
+                    hit_anything = true;
+                }
+            }
+
+            for (uint32_t i = leaf.object_begin; i < leaf.object_end; i++) {
+                if (objects[i]->hit(r, ray_t, rec, s)) {
+                    ray_t.max = rec.t;
+                    hit_anything = true;
+                }
+            }
+
+            return hit_anything;
+        }
+
+        // the batched tests still pick the closest of a leaf, but no record is written
+        bool occluded_leaf(const leaf_range& leaf, const ray& r, const interval& ray_t, sampler& s) const {
+            uint32_t index = 0;
+            double t = 0, alpha = 0, beta = 0;
+            if (leaf.sphere_begin < leaf.sphere_end && closest_sphere(leaf.sphere_begin, leaf.sphere_end, r, ray_t, index, t))
+                return true;
+            if (leaf.quad_begin < leaf.quad_end && closest_quad(leaf.quad_begin, leaf.quad_end, r, ray_t, index, t, alpha, beta))
+                return true;
+            for (uint32_t i = leaf.object_begin; i < leaf.object_end; i++) {
+                if (objects[i]->occluded(r, ray_t, s))
+                    return true;
+            }
+            return false;
+        }
+
+        // same root selection as sphere::hit, over [begin, end)
+        bool closest_sphere(uint32_t begin, uint32_t end, const ray& r, const interval& ray_t, uint32_t& index, double& t_hit) const {
+            const point3& o = r.origin();
+            const vec3& dir = r.direction();
+            double time = r.time();
+            double a = dot(dir, dir);
+            double t_max = ray_t.max;
+            bool found = false;
+
+            for (uint32_t base = begin; base < end; base += batch_size) {
+                int n = static_cast<int>(std::min<uint32_t>(batch_size, end - base));
+                double roots[batch_size];
+                bool valid[batch_size];
+
+                for (int k = 0; k < n; k++) {
+                    uint32_t i = base + k;
+                    double ocx = spheres.center_x[i] + time * spheres.velocity_x[i] - o.x();
+                    double ocy = spheres.center_y[i] + time * spheres.velocity_y[i] - o.y();
+                    double ocz = spheres.center_z[i] + time * spheres.velocity_z[i] - o.z();
+                    double h = ocx * dir.x() + ocy * dir.y() + ocz * dir.z();
+                    double c = (ocx * ocx + ocy * ocy + ocz * ocz) - spheres.radius[i] * spheres.radius[i];
+                    double discriminant = h * h - a * c;
+                    double sqrtd = std::sqrt(std::max(discriminant, 0.0));
+                    double near_root = (h - sqrtd) / a;
+                    double far_root = (h + sqrtd) / a;
+                    bool near_ok = near_root >= ray_t.min && near_root <= t_max;
+                    bool far_ok = far_root >= ray_t.min && far_root <= t_max;
+                    roots[k] = near_ok ? near_root : far_root;
+                    valid[k] = discriminant >= 0 && (near_ok || far_ok);
+                }
+
+                RT_COUNT_N(primitive_tests, n);
+                for (int k = 0; k < n; k++) {
+                    if (valid[k] && roots[k] <= t_max) {
+                        RT_COUNT(primitive_hits);
+                        t_max = roots[k];
+                        index = base + k;
+                        found = true;
+                    }
+                }
+            }
+
+            t_hit = t_max;
+            return found;
+        }
+
+        // same test as quad::hit, over [begin, end)
+        bool closest_quad(uint32_t begin, uint32_t end, const ray& r, const interval& ray_t, uint32_t& index,
+                          double& t_hit, double& alpha_hit, double& beta_hit) const {
+            const point3& o = r.origin();
+            const vec3& dir = r.direction();
+            double t_max = ray_t.max;
+            bool found = false;
+
+            for (uint32_t base = begin; base < end; base += batch_size) {
+                int n = static_cast<int>(std::min<uint32_t>(batch_size, end - base));
+                double ts[batch_size], alphas[batch_size], betas[batch_size];
+                bool valid[batch_size];
+
+                for (int k = 0; k < n; k++) {
+                    uint32_t i = base + k;
+                    double denom = quads.normal_x[i] * dir.x() + quads.normal_y[i] * dir.y() + quads.normal_z[i] * dir.z();
+                    double t = (quads.d[i] - (quads.normal_x[i] * o.x() + quads.normal_y[i] * o.y() + quads.normal_z[i] * o.z())) / denom;
+
+                    // planar hit point relative to Q
+                    double px = o.x() + t * dir.x() - quads.q_x[i];
+                    double py = o.y() + t * dir.y() - quads.q_y[i];
+                    double pz = o.z() + t * dir.z() - quads.q_z[i];
+
+                    // alpha = dot(w, cross(p, v)), beta = dot(u, cross(p, w))
+                    double pv_x = py * quads.v_z[i] - pz * quads.v_y[i];
+                    double pv_y = pz * quads.v_x[i] - px * quads.v_z[i];
+                    double pv_z = px * quads.v_y[i] - py * quads.v_x[i];
+                    double alpha = quads.w_x[i] * pv_x + quads.w_y[i] * pv_y + quads.w_z[i] * pv_z;
+
+                    double pw_x = py * quads.w_z[i] - pz * quads.w_y[i];
+                    double pw_y = pz * quads.w_x[i] - px * quads.w_z[i];
+                    double pw_z = px * quads.w_y[i] - py * quads.w_x[i];
+                    double beta = quads.u_x[i] * pw_x + quads.u_y[i] * pw_y + quads.u_z[i] * pw_z;
+
+                    ts[k] = t;
+                    alphas[k] = alpha;
+                    betas[k] = beta;
+                    valid[k] = std::fabs(denom) >= 1e-8 && t >= ray_t.min && t <= t_max
+                        && alpha >= 0 && alpha <= 1 && beta >= 0 && beta <= 1;
+                }
+
+                RT_COUNT_N(primitive_tests, n);
+                for (int k = 0; k < n; k++) {
+                    if (valid[k] && ts[k] <= t_max) {
+                        RT_COUNT(primitive_hits);
+                        t_max = ts[k];
+                        alpha_hit = alphas[k];
+                        beta_hit = betas[k];
+                        index = base + k;
+                        found = true;
+                    }
+                }
+            }
+
+            t_hit = t_max;
+            return found;
+        }
+
+        void set_sphere_record(uint32_t i, const ray& r, hit_record& rec) const {
+            point3 current_center = spheres.center(i, r.time());
+            rec.p = r.at(rec.t);
+            vec3 outward_normal = (rec.p - current_center) / spheres.radius[i];
+            rec.set_face_normal(r, outward_normal);
+            sphere::get_sphere_uv(outward_normal, rec.u, rec.v);
+            sphere::get_sphere_partials(spheres.radius[i] * outward_normal, rec.dpdu, rec.dpdv);
+            rec.mat = spheres.materials[i];
+        }
+
+        // the uv is the alpha, beta pair hit_leaf stored
+        void set_quad_record(uint32_t i, const ray& r, hit_record& rec) const {
+            rec.p = r.at(rec.t);
+            rec.mat = quads.materials[i];
+            rec.set_face_normal(r, vec3(quads.normal_x[i], quads.normal_y[i], quads.normal_z[i]));
+            rec.dpdu = vec3(quads.u_x[i], quads.u_y[i], quads.u_z[i]);
+            rec.dpdv = vec3(quads.v_x[i], quads.v_y[i], quads.v_z[i]);
+        }
+    };
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include "hittable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace My
+{
+    // a density sampled at resolution^3 points over a box and read back trilinearly. procedural densities, like a
+    // noise texture, are baked into one once: lookups get cheap, and the density between two lattice points
+    // never exceeds them, which gives exact majorants
+    class density_grid
+    {
+    public:
+        density_grid() = default;
+
+        // density(p) is the extinction per unit length at p, zero or more
+        template <typename F>
+        density_grid(const aabb& box, int resolution, F&& density) : box(box), n(std::max(resolution, 2)) {
+            values.resize(static_cast<size_t>(n) * n * n);
+            for (int k = 0; k < n; k++)
+                for (int j = 0; j < n; j++)
+                    for (int i = 0; i < n; i++)
+                        values[index(i, j, k)] = static_cast<float>(std::fmax(0.0, density(lattice_point(i, j, k))));
+        }
+
+        int resolution() const { return n; }
+        const aabb& bounds() const { return box; }
+
+        double value(const point3& p) const {
+            int i[3];
+            double f[3];
+            for (int a = 0; a < 3; a++) {
+                const interval& axis = box.axis_interval(a);
+                double x = std::clamp<double>((p[a] - axis.min) / axis.size() * (n - 1), 0.0, double(n - 1));
+                i[a] = std::min(static_cast<int>(x), n - 2);
+                f[a] = x - i[a];
+            }
+
+            auto lerp = [](double a, double b, double t) { return a + t * (b - a); };
+            auto v = [&](int di, int dj, int dk) { return double(values[index(i[0] + di, i[1] + dj, i[2] + dk)]); };
+            double x00 = lerp(v(0, 0, 0), v(1, 0, 0), f[0]);
+            double x10 = lerp(v(0, 1, 0), v(1, 1, 0), f[0]);
+            double x01 = lerp(v(0, 0, 1), v(1, 0, 1), f[0]);
+            double x11 = lerp(v(0, 1, 1), v(1, 1, 1), f[0]);
+            return lerp(lerp(x00, x10, f[1]), lerp(x01, x11, f[1]), f[2]);
+        }
+
+        // the largest lattice value in [lo, hi] on every axis, in lattice coordinates; it bounds the density
+        // anywhere between those points
+        double max_over(const int lo[3], const int hi[3]) const {
+            float m = 0;
+            for (int k = lo[2]; k <= hi[2]; k++)
+                for (int j = lo[1]; j <= hi[1]; j++)
+                    for (int i = lo[0]; i <= hi[0]; i++)
+                        m = std::max(m, values[index(i, j, k)]);
+            return m;
+        }
+
+        size_t memory_bytes() const { return values.size() * sizeof(float); }
+
+    private:
+        aabb box;
+        int n = 0;
+        std::vector<float> values;
+
+        size_t index(int i, int j, int k) const { return (static_cast<size_t>(k) * n + j) * n + i; }
+
+        point3 lattice_point(int i, int j, int k) const {
+            int ijk[3] = { i, j, k };
+            point3 p;
+            for (int a = 0; a < 3; a++) {
+                const interval& axis = box.axis_interval(a);
+                p[a] = axis.min + axis.size() * ijk[a] / (n - 1);
+            }
+            return p;
+        }
+    };
+
+    // a volume of varying density inside a convex boundary, sampled by delta tracking. a coarse grid over the
+    // boundary's box keeps the largest density of each of its cells, the majorant. a ray walks the cells it
+    // crosses and draws tentative collisions at the rate of each cell's majorant; one at p is real with
+    // probability density(p) / majorant and the others are null collisions that leave the ray as it was.
+    // that is exact for any majorant at or above the density, and the tighter the majorant, the fewer the
+    // lookups: thin or empty cells are skipped in a step or two
+    class heterogeneous_medium : public hittable
+    {
+    public:
+        // density covers the boundary's bounding box; phase_function is expected to be an isotropic material
+        heterogeneous_medium(shared_ptr<hittable> boundary, density_grid density, material_id phase_function,
+                             int majorant_resolution = 16)
+            : boundary(boundary), density(std::move(density)), phase_function(phase_function),
+              cells(std::max(majorant_resolution, 1))
+        {
+            int n = this->density.resolution();
+            majorants.resize(static_cast<size_t>(cells) * cells * cells);
+            for (int k = 0; k < cells; k++) {
+                for (int j = 0; j < cells; j++) {
+                    for (int i = 0; i < cells; i++) {
+                        // the lattice points of every lattice cell that overlaps this grid cell
+                        int ijk[3] = { i, j, k }, lo[3], hi[3];
+                        for (int a = 0; a < 3; a++) {
+                            lo[a] = static_cast<int>(std::floor(double(ijk[a]) * (n - 1) / cells));
+                            hi[a] = std::min(static_cast<int>(std::ceil(double(ijk[a] + 1) * (n - 1) / cells)), n - 1);
+                        }
+                        majorants[(static_cast<size_t>(k) * cells + j) * cells + i] = static_cast<float>(this->density.max_over(lo, hi));
+                    }
+                }
+            }
+        }
+
+        bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+            double t;
+            if (!track(r, ray_t, s, t))
+                return false;
+
+            rec.t = t;
+            rec.p = r.at(t);
+            rec.normal = rec.geometric_normal = vec3(1, 0, 0);
+            rec.front_face = true;
+            rec.dpdu = rec.dpdv = vec3(0, 0, 0);
+            rec.mat = phase_function;
+            rec.surface = nullptr;
+            return true;
+        }
+
+        // a collision before the end blocks the ray; its chance is one minus the transmittance, as for a hit
+        bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+            double t;
+            return track(r, ray_t, s, t);
+        }
+
+        aabb bounding_box() const override { return boundary->bounding_box(); }
+
+        size_t memory_bytes() const { return density.memory_bytes() + majorants.size() * sizeof(float); }
+
+    private:
+        shared_ptr<hittable> boundary;
+        density_grid density;
+        material_id phase_function;
+        int cells;
+        std::vector<float> majorants;
+
+        // the first real collision within ray_t, walking the majorant cells front to back
+        bool track(const ray& r, interval ray_t, sampler& s, double& t_hit) const {
+            double enter, exit;
+            if (!boundary->crossings(r, enter, exit, s))
+                return false;
+            enter = std::fmax(std::fmax(enter, double(ray_t.min)), 0.0);
+            exit = std::fmin(exit, double(ray_t.max));
+            if (enter >= exit)
+                return false;
+
+            // the ray in grid coordinates, one unit per cell
+            const aabb& box = density.bounds();
+            int cell[3], step[3];
+            double next[3], delta[3];
+            for (int a = 0; a < 3; a++) {
+                const interval& axis = box.axis_interval(a);
+                double scale = cells / axis.size();
+                double o = (r.origin()[a] - axis.min) * scale;
+                double d = r.direction()[a] * scale;
+                cell[a] = std::clamp(static_cast<int>(std::floor(o + enter * d)), 0, cells - 1);
+                if (d > 0) {
+                    step[a] = 1;
+                    next[a] = (cell[a] + 1 - o) / d;
+                    delta[a] = 1 / d;
+                } else if (d < 0) {
+                    step[a] = -1;
+                    next[a] = (cell[a] - o) / d;
+                    delta[a] = -1 / d;
+                } else {
+                    step[a] = 0;
+                    next[a] = infinity;
+                    delta[a] = infinity;
+                }
+            }
+
+            double ray_length = r.direction().length();
+            double t = enter;
+            while (true) {
+                int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+                double cell_end = std::fmin(next[axis], exit);
+                double majorant = majorants[(static_cast<size_t>(cell[2]) * cells + cell[1]) * cells + cell[0]];
+
+                if (majorant > 0) {
+                    double rate = majorant * ray_length;
+                    while (true) {
+                        t -= std::log(1 - s.get_1d()) / rate;
+                        if (t >= cell_end)
+                            break;
+                        if (s.get_1d() * majorant < density.value(r.at(t))) {
+                            t_hit = t;
+                            return true;
+                        }
+                    }
+                }
+
+                // collisions are memoryless, so sampling starts over at the next cell with its own majorant
+                t = std::fmax(cell_end, enter);
+                if (t >= exit)
+                    return false;
+                cell[axis] += step[axis];
+                if (cell[axis] < 0 || cell[axis] >= cells)
+                    return false;
+                next[axis] += delta[axis];
+            }
+        }
+    };
+}
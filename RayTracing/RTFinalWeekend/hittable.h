@@ -1,140 +1,308 @@
-#pragma once
-#include "ray.h"
-#include "interval.h"
-#include "aabb.h"
-
-namespace My {
-    class material;
-
-    class hit_record {
-        public:
-            point3 p;
-            vec3 normal;
-            shared_ptr<material> mat;
-            double t;
-            double u;
-            double v;
-            bool front_face;
-
-            void set_face_normal(const ray& r, const vec3& outward_normal) {
-                front_face = dot(r.direction(), outward_normal) < 0;
-                normal = front_face ? outward_normal : -outward_normal;
-            }
-    };
-
-    class hittable {
-        public:
-            virtual ~hittable() = default;
-
-            virtual bool hit(const ray& r, interval ray_t, hit_record& rec) const = 0;
-
-            virtual aabb bounding_box() const = 0;
-    };
-
-    class translate : public hittable {
-        public:
-            translate(shared_ptr<hittable> object, const vec3& offset)
-                : object(object), offset(offset) {
-                    bbox = object->bounding_box() + offset;
-            }
-
-            bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
-                ray offset_r(r.origin() - offset, r.direction(), r.time());
-
-                if (!object->hit(offset_r, ray_t, rec)) {
-                    return false;
-                }
-
-                rec.p += offset;
-
-                return true;
-            }
-
-            aabb bounding_box() const override { return bbox; }
-            
-
-        private:
-            shared_ptr<hittable> object;
-            vec3 offset;
-            aabb bbox;
-    };
-
-    class rotate_y : public hittable {
-        public:
-            rotate_y(shared_ptr<hittable> object, double angle) : object(object) {
-                auto radians = degrees_to_radians(angle);
-                sin_theta = std::sin(radians);
-                cos_theta = std::cos(radians);
-                bbox = object->bounding_box();
-
-                point3 min(infinity, infinity, infinity);
-                point3 max(-infinity, -infinity, -infinity);
-
-                for (int i = 0; i < 2; i++) {
-                    for (int j = 0; j < 2; j++) {
-                        for (int k = 0; k < 2; k++) {
-                            auto x = i * bbox.x.max + (1 - i) * bbox.x.min;
-                            auto y = j * bbox.y.max + (1 - j) * bbox.y.min;
-                            auto z = k * bbox.z.max + (1 - k) * bbox.z.min;
-
-                            auto newx = cos_theta * x + sin_theta * z;
-                            auto newz = -sin_theta * x + cos_theta * z;
-
-                            vec3 tester(newx, y, newz);
-
-                            for (int c = 0; c < 3; c++) {
-                                min[c] = std::min(min[c], tester[c]);
-                                max[c] = std::max(max[c], tester[c]);
-                            }
-                        }
-                    }
-                }
-
-                bbox = aabb(min, max);
-            }
-
-            bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
-                // transform the ray from world space to object space
-                auto origin = point3(
-                    (cos_theta * r.origin().x() - sin_theta * r.origin().z()),
-                    r.origin().y(),
-                    (sin_theta * r.origin().x() + cos_theta * r.origin().z())
-                );
-
-                auto direction = vec3(
-                    (cos_theta * r.direction().x() - sin_theta * r.direction().z()),
-                    r.direction().y(),
-                    (sin_theta * r.direction().x() + cos_theta * r.direction().z())
-                );
-
-                ray rotated_r(origin, direction, r.time());
-
-                if (!object->hit(rotated_r, ray_t, rec)) {
-                    return false;
-                }
-
-                // transform the hit point and normal from object space to world space  
-                rec.p = point3(
-                    (cos_theta * rec.p.x() + sin_theta * rec.p.z()),
-                    rec.p.y(),
-                    (-sin_theta * rec.p.x() + cos_theta * rec.p.z())
-                );
-
-                rec.normal = vec3(
-                    (cos_theta * rec.normal.x() + sin_theta * rec.normal.z()),
-                    rec.normal.y(),
-                    (-sin_theta * rec.normal.x() + cos_theta * rec.normal.z())
-                );
-
-                return true;
-            }
-
-            aabb bounding_box() const override { return bbox; }
-
-        private:
-            shared_ptr<hittable> object;
-            double sin_theta;
-            double cos_theta;
-            aabb bbox;
-    };
+#pragma once
+#include "ray.h"
+#include "interval.h"
+#include "aabb.h"
+
+namespace My {
+    // index of a material in the scene's material_table
+    using material_id = uint32_t;
+
+    class hittable;
+
+    class hit_record {
+        public:
+            point3 p;
+            vec3 normal;                // the shading normal, on the side the ray came from
+            vec3 geometric_normal;      // the surface's own normal on the same side
+            material_id mat;
+            double t;
+            double u;
+            double v;
+            bool front_face;
+            vec3 dpdu, dpdv;            // how p moves with u and v, zero where a surface has no uv mapping
+            uv_footprint footprint;     // zero unless set_footprint was called
+
+            // primitives only record t (and whatever else is free) for a candidate hit and leave
+            // p, normal, uv and mat to surface->set_surface, run once for the closest hit
+            const hittable* surface = nullptr;
+            uint32_t primitive = 0;
+
+            // transforms defer too: one whose object hit becomes the surface and keeps the object's surface here,
+            // innermost first. only the entries under the current surface belong to this hit; a sibling that hit
+            // closer leaves stale ones behind, which defer_to drops
+            struct deferred_transform {
+                const hittable* transform;
+                const hittable* inner;
+            };
+            static constexpr int max_deferred = 4;
+            deferred_transform deferred[max_deferred];
+            int deferred_count = 0;
+
+            void set_face_normal(const ray& r, const vec3& outward_normal) {
+                front_face = dot(r.direction(), outward_normal) < 0;
+                normal = front_face ? outward_normal : -outward_normal;
+                geometric_normal = normal;
+            }
+
+            // a ray leaving the surface at p. its origin is moved off the surface to the side the ray goes,
+            // so the ray can start at t = 0 without finding this surface again
+            ray spawn_ray(const vec3& direction, double time) const {
+                vec3 side = dot(direction, geometric_normal) > 0 ? geometric_normal : -geometric_normal;
+                return ray(offset_ray_origin(p, side), direction, time);
+            }
+
+            // a ray from the surface at p to target, which it reaches at t = 1. the direction is taken after the
+            // offset, so the ray still ends on target however far the origin moved
+            ray spawn_ray_to(const point3& target, double time) const {
+                vec3 side = dot(target - p, geometric_normal) > 0 ? geometric_normal : -geometric_normal;
+                point3 origin = offset_ray_origin(p, side);
+                return ray(origin, target - origin, time);
+            }
+
+            // fills in the deferred surface attributes, r is the ray the hit was found with
+            void finish_surface(const ray& r);
+
+            // called by a transform whose object just hit, to become the surface. false if transforms nest too
+            // deep to defer, and the caller has to finish the surface itself
+            bool defer_to(const hittable* transform) {
+                if (deferred_count > 0 && deferred[deferred_count - 1].transform != surface)
+                    deferred_count = 0;
+                if (deferred_count == max_deferred)
+                    return false;
+                deferred[deferred_count++] = { transform, surface };
+                surface = transform;
+                return true;
+            }
+
+            // for a transform's set_surface: finishes the surface of its object, with the ray in object space
+            void finish_inner(const ray& object_r) {
+                surface = deferred[--deferred_count].inner;
+                finish_surface(object_r);
+            }
+
+            // the uv footprint of a finished hit from the differentials of its ray: each neighbouring ray meets
+            // the tangent plane at p, and its offset from p is expressed in dpdu and dpdv by least squares
+            void set_footprint(const ray_differential& d) {
+                footprint = uv_footprint();
+                double uu = dot(dpdu, dpdu), uv = dot(dpdu, dpdv), vv = dot(dpdv, dpdv);
+                double det = uu * vv - uv * uv;
+                if (!(det > 1e-12 * uu * vv))
+                    return;
+
+                double plane = dot(normal, p);
+                double denom_x = dot(normal, d.rx_direction), denom_y = dot(normal, d.ry_direction);
+                if (denom_x == 0 || denom_y == 0)
+                    return;
+                vec3 dpdx = d.rx_origin + ((plane - dot(normal, d.rx_origin)) / denom_x) * d.rx_direction - p;
+                vec3 dpdy = d.ry_origin + ((plane - dot(normal, d.ry_origin)) / denom_y) * d.ry_direction - p;
+
+                auto solve = [&](const vec3& dp, double& du, double& dv) {
+                    double a = dot(dpdu, dp), b = dot(dpdv, dp);
+                    du = (vv * a - uv * b) / det;
+                    dv = (uu * b - uv * a) / det;
+                };
+                solve(dpdx, footprint.dudx, footprint.dvdx);
+                solve(dpdy, footprint.dudy, footprint.dvdy);
+
+                // a neighbouring ray nearly parallel to the plane lands far off; its step says nothing useful
+                if (!std::isfinite(footprint.dudx + footprint.dvdx + footprint.dudy + footprint.dvdy))
+                    footprint = uv_footprint();
+            }
+    };
+
+    class hittable {
+        public:
+            virtual ~hittable() = default;
+
+            virtual bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const = 0;
+
+            // any-hit query for shadow rays, true if something blocks r within ray_t.
+            // overrides stop at the first hit and skip the surface attributes
+            virtual bool occluded(const ray& r, interval ray_t, sampler& s) const {
+                hit_record rec;
+                return hit(r, ray_t, rec, s);
+            }
+
+            // where the line of r is inside this object, for the convex boundaries of volumes: enter and exit are the
+            // first and the last crossing of the surface, at any t. the default asks hit for the two in turn;
+            // overrides find both in one pass
+            virtual bool crossings(const ray& r, double& enter, double& exit, sampler& s) const {
+                hit_record rec1, rec2;
+                if (!hit(r, interval::universe, rec1, s))
+                    return false;
+
+                // past the entry by more than the rounding of t to real, or the entry would be found again
+                double after_entry = rec1.t + 0.0001 + 4 * std::numeric_limits<real>::epsilon() * std::fabs(rec1.t);
+                if (!hit(r, interval(after_entry, infinity), rec2, s))
+                    return false;
+
+                enter = rec1.t;
+                exit = rec2.t;
+                return true;
+            }
+
+            virtual aabb bounding_box() const = 0;
+
+            // the bounds at a time in the shutter interval [0, 1]. objects move linearly, so the box interpolated
+            // between the bounds at 0 and 1 contains the object at any time in between. the default, the box
+            // over the whole shutter, is right for static objects and safe for everything else
+            virtual aabb bounds_at(double time) const { return bounding_box(); }
+
+            // computes the attributes of a hit this object deferred in hit()
+            virtual void set_surface(const ray& r, hit_record& rec) const {}
+    };
+
+    inline void hit_record::finish_surface(const ray& r) {
+        if (surface) {
+            surface->set_surface(r, *this);
+            surface = nullptr;
+        }
+    }
+
+    class translate : public hittable {
+        public:
+            translate(shared_ptr<hittable> object, const vec3& offset)
+                : object(object), offset(offset) {
+                    bbox = object->bounding_box() + offset;
+            }
+
+            bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+                ray offset_r(r.origin() - offset, r.direction(), r.time());
+
+                if (!object->hit(offset_r, ray_t, rec, s)) {
+                    return false;
+                }
+
+                // the surface waits for the closest hit, unless transforms nest too deep to defer it
+                if (!rec.defer_to(this)) {
+                    rec.finish_surface(offset_r);
+                    rec.p += offset;
+                }
+
+                return true;
+            }
+
+            void set_surface(const ray& r, hit_record& rec) const override {
+                rec.finish_inner(ray(r.origin() - offset, r.direction(), r.time()));
+                rec.p += offset;
+            }
+
+            bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+                return object->occluded(ray(r.origin() - offset, r.direction(), r.time()), ray_t, s);
+            }
+
+            bool crossings(const ray& r, double& enter, double& exit, sampler& s) const override {
+                return object->crossings(ray(r.origin() - offset, r.direction(), r.time()), enter, exit, s);
+            }
+
+            aabb bounding_box() const override { return bbox; }
+            
+
+        private:
+            shared_ptr<hittable> object;
+            vec3 offset;
+            aabb bbox;
+    };
+
+    class rotate_y : public hittable {
+        public:
+            rotate_y(shared_ptr<hittable> object, double angle) : object(object) {
+                auto radians = degrees_to_radians(angle);
+                sin_theta = std::sin(radians);
+                cos_theta = std::cos(radians);
+                bbox = object->bounding_box();
+
+                point3 min(infinity, infinity, infinity);
+                point3 max(-infinity, -infinity, -infinity);
+
+                for (int i = 0; i < 2; i++) {
+                    for (int j = 0; j < 2; j++) {
+                        for (int k = 0; k < 2; k++) {
+                            auto x = i * bbox.x.max + (1 - i) * bbox.x.min;
+                            auto y = j * bbox.y.max + (1 - j) * bbox.y.min;
+                            auto z = k * bbox.z.max + (1 - k) * bbox.z.min;
+
+                            auto newx = cos_theta * x + sin_theta * z;
+                            auto newz = -sin_theta * x + cos_theta * z;
+
+                            vec3 tester(newx, y, newz);
+
+                            for (int c = 0; c < 3; c++) {
+                                min[c] = std::min(min[c], tester[c]);
+                                max[c] = std::max(max[c], tester[c]);
+                            }
+                        }
+                    }
+                }
+
+                bbox = aabb(min, max);
+            }
+
+            bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+                ray rotated_r = to_object(r);
+                if (!object->hit(rotated_r, ray_t, rec, s)) {
+                    return false;
+                }
+
+                // the surface waits for the closest hit, unless transforms nest too deep to defer it
+                if (!rec.defer_to(this)) {
+                    rec.finish_surface(rotated_r);
+                    surface_to_world(rec);
+                }
+
+                return true;
+            }
+
+            void set_surface(const ray& r, hit_record& rec) const override {
+                rec.finish_inner(to_object(r));
+                surface_to_world(rec);
+            }
+
+            bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+                return object->occluded(to_object(r), ray_t, s);
+            }
+
+            bool crossings(const ray& r, double& enter, double& exit, sampler& s) const override {
+                return object->crossings(to_object(r), enter, exit, s);
+            }
+
+            aabb bounding_box() const override { return bbox; }
+
+        private:
+            // transform a point or direction from object space to world space
+            vec3 to_world(const vec3& v) const {
+                return vec3(cos_theta * v.x() + sin_theta * v.z(), v.y(), -sin_theta * v.x() + cos_theta * v.z());
+            }
+
+            // the hit point, normals and surface derivatives of a finished surface, from object to world space
+            void surface_to_world(hit_record& rec) const {
+                rec.p = to_world(rec.p);
+                rec.normal = to_world(rec.normal);
+                rec.geometric_normal = to_world(rec.geometric_normal);
+                rec.dpdu = to_world(rec.dpdu);
+                rec.dpdv = to_world(rec.dpdv);
+            }
+
+            // transform the ray from world space to object space
+            ray to_object(const ray& r) const {
+                auto origin = point3(
+                    (cos_theta * r.origin().x() - sin_theta * r.origin().z()),
+                    r.origin().y(),
+                    (sin_theta * r.origin().x() + cos_theta * r.origin().z())
+                );
+
+                auto direction = vec3(
+                    (cos_theta * r.direction().x() - sin_theta * r.direction().z()),
+                    r.direction().y(),
+                    (sin_theta * r.direction().x() + cos_theta * r.direction().z())
+                );
+
+                return ray(origin, direction, r.time());
+            }
+
+            shared_ptr<hittable> object;
+            double sin_theta;
+            double cos_theta;
+            aabb bbox;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "framebuffer.h"
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RT_IMAGE_SSE 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace My
+{
+    // p3 is the book's ascii ppm, p6 binary ppm, both gamma 2 and 8 bits.
+    // pfm keeps the linear floats as they are, hdr is radiance rgbe (shared 8-bit exponent)
+    enum class image_format { p3, p6, pfm, hdr };
+
+    inline const char* image_format_name(image_format format) {
+        switch (format) {
+            case image_format::p3: return "p3";
+            case image_format::p6: return "p6";
+            case image_format::pfm: return "pfm";
+            case image_format::hdr: return "hdr";
+        }
+        return "?";
+    }
+
+    inline bool parse_image_format(const char* name, image_format& format) {
+        for (auto f : { image_format::p3, image_format::p6, image_format::pfm, image_format::hdr }) {
+            if (std::strcmp(name, image_format_name(f)) == 0) {
+                format = f;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // picks the format from a file extension: .pfm, .hdr, anything else is binary ppm
+    inline image_format image_format_for_path(const std::string& path) {
+        auto ends_with = [&](const char* ext) {
+            size_t n = std::strlen(ext);
+            return path.size() >= n && path.compare(path.size() - n, n, ext) == 0;
+        };
+        if (ends_with(".pfm")) return image_format::pfm;
+        if (ends_with(".hdr")) return image_format::hdr;
+        return image_format::p6;
+    }
+
+    // gamma 2 and quantize to bytes, the same mapping as the book's write_color:
+    // int(256 * clamp(sqrt(x), 0, 0.999))
+    inline void linear_to_srgb8(const float* in, uint8_t* out, size_t n) {
+        size_t i = 0;
+#ifdef RT_IMAGE_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 top = _mm_set1_ps(0.999f);
+        const __m128 scale = _mm_set1_ps(256.0f);
+        auto quantize = [&](const float* p) {
+            __m128 v = _mm_sqrt_ps(_mm_max_ps(_mm_loadu_ps(p), zero));
+            return _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(v, top), scale));
+        };
+        for (; i + 16 <= n; i += 16) {
+            __m128i a = _mm_packs_epi32(quantize(in + i), quantize(in + i + 4));
+            __m128i b = _mm_packs_epi32(quantize(in + i + 8), quantize(in + i + 12));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+        }
+#endif
+        for (; i < n; i++) {
+            float v = in[i] > 0 ? std::sqrt(in[i]) : 0.0f;
+            out[i] = static_cast<uint8_t>(256 * (v < 0.999f ? v : 0.999f));
+        }
+    }
+
+    // the whole file in memory, so it goes out in a single write
+    inline std::vector<char> encode_image(const framebuffer& image, image_format format) {
+        int width = image.width();
+        int height = image.height();
+        size_t values = image.pixel_count() * 3;
+        std::vector<char> out;
+
+        char header[64];
+        auto append_header = [&](int length) { out.insert(out.end(), header, header + length); };
+
+        switch (format) {
+            case image_format::p3: {
+                std::vector<uint8_t> bytes(values);
+                linear_to_srgb8(image.data(), bytes.data(), values);
+                append_header(std::snprintf(header, sizeof(header), "P3\n%d %d\n255\n", width, height));
+                out.reserve(out.size() + values * 4);
+                for (size_t i = 0; i < values; i++) {
+                    unsigned b = bytes[i];
+                    if (b >= 100) out.push_back(static_cast<char>('0' + b / 100));
+                    if (b >= 10) out.push_back(static_cast<char>('0' + b / 10 % 10));
+                    out.push_back(static_cast<char>('0' + b % 10));
+                    out.push_back(i % 3 == 2 ? '\n' : ' ');
+                }
+                break;
+            }
+            case image_format::p6: {
+                int length = std::snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+                out.resize(length + values);
+                std::memcpy(out.data(), header, length);
+                linear_to_srgb8(image.data(), reinterpret_cast<uint8_t*>(out.data() + length), values);
+                break;
+            }
+            case image_format::pfm: {
+                // negative scale means little endian, rows run bottom to top
+                int length = std::snprintf(header, sizeof(header), "PF\n%d %d\n-1.0\n", width, height);
+                size_t row_bytes = static_cast<size_t>(width) * 3 * sizeof(float);
+                out.resize(length + row_bytes * height);
+                std::memcpy(out.data(), header, length);
+                for (int j = 0; j < height; j++)
+                    std::memcpy(out.data() + length + row_bytes * (height - 1 - j), image.data() + static_cast<size_t>(j) * width * 3, row_bytes);
+                break;
+            }
+            case image_format::hdr: {
+                // flat scanlines, no run length encoding
+                int length = std::snprintf(header, sizeof(header), "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", height, width);
+                out.resize(length + image.pixel_count() * 4);
+                std::memcpy(out.data(), header, length);
+                auto* rgbe = reinterpret_cast<uint8_t*>(out.data() + length);
+                const float* p = image.data();
+                for (size_t i = 0; i < image.pixel_count(); i++, p += 3, rgbe += 4) {
+                    float v = std::fmax(p[0], std::fmax(p[1], p[2]));
+                    if (!(v > 1e-32f)) {
+                        rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+                        continue;
+                    }
+                    int e;
+                    float scale = std::frexp(v, &e) * 256.0f / v;
+                    rgbe[0] = static_cast<uint8_t>(std::fmax(p[0], 0.0f) * scale);
+                    rgbe[1] = static_cast<uint8_t>(std::fmax(p[1], 0.0f) * scale);
+                    rgbe[2] = static_cast<uint8_t>(std::fmax(p[2], 0.0f) * scale);
+                    rgbe[3] = static_cast<uint8_t>(e + 128);
+                }
+                break;
+            }
+        }
+
+        return out;
+    }
+
+    // encodes and writes images on a background thread, so rendering can go on meanwhile.
+    // an empty path or "-" writes to stdout
+    class image_writer
+    {
+    public:
+        image_writer() : worker([this] { run(); }) {}
+
+        ~image_writer() {
+            wait();
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                done = true;
+            }
+            wake.notify_all();
+            worker.join();
+        }
+
+        image_writer(const image_writer&) = delete;
+        image_writer& operator=(const image_writer&) = delete;
+
+        void write(framebuffer image, std::string path, image_format format) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                jobs.push_back({ std::move(image), std::move(path), format });
+            }
+            wake.notify_all();
+        }
+
+        // blocks until every queued image is written, false if any of them failed
+        bool wait() {
+            std::unique_lock<std::mutex> guard(lock);
+            idle.wait(guard, [this] { return jobs.empty() && !busy; });
+            return !failed;
+        }
+
+    private:
+        struct job {
+            framebuffer image;
+            std::string path;
+            image_format format;
+        };
+
+        std::mutex lock;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        std::deque<job> jobs;
+        bool busy = false;
+        bool done = false;
+        bool failed = false;
+        std::thread worker;
+
+        void run() {
+            std::unique_lock<std::mutex> guard(lock);
+            while (true) {
+                wake.wait(guard, [this] { return done || !jobs.empty(); });
+                if (jobs.empty())
+                    return;
+
+                job next = std::move(jobs.front());
+                jobs.pop_front();
+                busy = true;
+                guard.unlock();
+
+                bool ok = write_file(next);
+
+                guard.lock();
+                failed = failed || !ok;
+                busy = false;
+                idle.notify_all();
+            }
+        }
+
+        static bool write_file(const job& j) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<char> bytes = encode_image(j.image, j.format);
+
+            bool to_stdout = j.path.empty() || j.path == "-";
+            std::FILE* file = stdout;
+            if (to_stdout) {
+#ifdef _WIN32
+                _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            } else {
+                file = std::fopen(j.path.c_str(), "wb");
+                if (!file) {
+                    std::cerr << "ERROR: could not open '" << j.path << "' for writing.\n";
+                    return false;
+                }
+            }
+
+            bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+            ok = (to_stdout ? std::fflush(file) : std::fclose(file)) == 0 && ok;
+            if (!ok) {
+                std::cerr << "ERROR: could not write '" << (to_stdout ? "stdout" : j.path) << "'.\n";
+                return false;
+            }
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            std::clog << "Wrote " << image_format_name(j.format) << " image (" << bytes.size() << " bytes) to "
+                      << (to_stdout ? "stdout" : j.path) << " in " << elapsed.count() << " ms" << std::endl;
+            return true;
+        }
+    };
+}
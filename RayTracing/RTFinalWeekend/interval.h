@@ -1,52 +1,61 @@
-#pragma once
-
-namespace My {
-    class interval {
-        public:
-            double min, max;
-
-            interval() : min(+infinity), max(-infinity) {}
-
-            interval(double min, double max) : min(min), max(max) {}
-
-            interval(const interval& a, const interval& b) {
-                min = a.min < b.min ? a.min : b.min;
-                max = a.max > b.max ? a.max : b.max;
-            }
-
-            double size() const {
-                return max - min;
-            }
-
-            bool contains(double x) const {
-                return x >= min && x <= max;
-            }
-
-            bool surrounds(double x) const {
-                return x < min || x > max;
-            }
-
-            double clamp(double x) const {
-                return x < min ? min : x > max ? max : x;
-            }
-
-            // avoid floating point rounding errors with grazing cases
-            interval expand(double delta) const {
-                auto padding = delta * 0.5;
-                return interval(min - padding, max + padding);
-            }
-
-            static const interval empty, universe;
-    };
-
-    const interval interval::empty = interval(+infinity, -infinity);
-    const interval interval::universe = interval(-infinity, +infinity);
-
-    interval operator+(const interval& ival, double displacement) {
-        return interval(ival.min + displacement, ival.max + displacement);
-    }
-
-    interval operator+(double displacement, const interval& ival) {
-        return ival + displacement;
-    }
-}
\ No newline at end of file
+#pragma once
+
+namespace My {
+    template <typename T>
+    class basic_interval {
+        public:
+            using value_type = T;
+
+            T min, max;
+
+            basic_interval() : min(+infinity), max(-infinity) {}
+
+            basic_interval(T min, T max) : min(min), max(max) {}
+
+            basic_interval(const basic_interval& a, const basic_interval& b) {
+                min = a.min < b.min ? a.min : b.min;
+                max = a.max > b.max ? a.max : b.max;
+            }
+
+            T size() const {
+                return max - min;
+            }
+
+            bool contains(T x) const {
+                return x >= min && x <= max;
+            }
+
+            bool surrounds(T x) const {
+                return x < min || x > max;
+            }
+
+            T clamp(T x) const {
+                return x < min ? min : x > max ? max : x;
+            }
+
+            // avoid floating point rounding errors with grazing cases
+            basic_interval expand(T delta) const {
+                auto padding = delta * T(0.5);
+                return basic_interval(min - padding, max + padding);
+            }
+
+            static const basic_interval empty, universe;
+    };
+
+    template <typename T>
+    const basic_interval<T> basic_interval<T>::empty = basic_interval<T>(+infinity, -infinity);
+    template <typename T>
+    const basic_interval<T> basic_interval<T>::universe = basic_interval<T>(-infinity, +infinity);
+
+    using interval = basic_interval<real>;
+
+    template <typename T>
+    basic_interval<T> operator+(const basic_interval<T>& ival, typename basic_interval<T>::value_type displacement) {
+        return basic_interval<T>(ival.min + displacement, ival.max + displacement);
+    }
+
+    template <typename T>
+    basic_interval<T> operator+(typename basic_interval<T>::value_type displacement, const basic_interval<T>& ival) {
+        return ival + displacement;
+    }
+}
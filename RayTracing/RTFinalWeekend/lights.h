@@ -0,0 +1,322 @@
+#pragma once
+#include "hittable.h"
+#include "hittable_list.h"
+#include "material.h"
+#include "quad.h"
+#include "sphere.h"
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+#include <vector>
+
+namespace My
+{
+    // a point sampled on a light, as seen from a shading point
+    struct light_sample
+    {
+        vec3 direction;     // unit vector from the shading point towards the light
+        double distance;
+        double pdf;         // solid angle density, light selection included
+        color radiance;
+    };
+
+    // mis weight of a sample drawn with density f_pdf against a second strategy with density g_pdf (beta = 2)
+    inline double power_heuristic(double f_pdf, double g_pdf) {
+        double f2 = f_pdf * f_pdf;
+        double g2 = g_pdf * g_pdf;
+        return f2 / (f2 + g2);
+    }
+
+    // registry of the emissive spheres and quads of a scene for next-event estimation.
+    // a light is picked uniformly, then a direction towards it: a uniform cone for spheres, a uniform
+    // spherical rectangle for rectangular quads (area sampling for other parallelograms or tiny solid angles)
+    class light_list
+    {
+    public:
+        // registers every plain sphere and quad with an emissive material, descending into nested lists.
+        // lights behind translate, rotate_y, an instance_bvh or an accelerator are not seen and stay reachable by bsdf sampling only
+        void collect(const hittable_list& list, const material_table& materials) {
+            for (const auto& object : list.objects) {
+                const auto& type = typeid(*object);
+                if (type == typeid(hittable_list)) {
+                    collect(static_cast<const hittable_list&>(*object), materials);
+                } else if (type == typeid(sphere)) {
+                    const auto& sp = static_cast<const sphere&>(*object);
+                    if (materials.is_emissive(sp.mat))
+                        add_sphere(sp.center.origin(), sp.center.direction(), sp.radius, sp.mat);
+                } else if (type == typeid(quad)) {
+                    const auto& qd = static_cast<const quad&>(*object);
+                    if (materials.is_emissive(qd.mat))
+                        add_quad(qd.Q, qd.u, qd.v, qd.mat);
+                }
+            }
+        }
+
+        void add_sphere(const point3& center, const vec3& velocity, double radius, material_id mat) {
+            light l;
+            l.kind = light_kind::sphere;
+            l.origin = center;
+            l.edge_u = velocity;
+            l.radius = radius;
+            l.mat = mat;
+            lights.push_back(l);
+        }
+
+        void add_quad(const point3& Q, const vec3& u, const vec3& v, material_id mat) {
+            light l;
+            l.kind = light_kind::quad;
+            l.origin = Q;
+            l.edge_u = u;
+            l.edge_v = v;
+            auto n = cross(u, v);
+            l.area = n.length();
+            l.normal = n / l.area;
+            l.w = n / dot(n, n);
+            l.rectangle = std::fabs(dot(u, v)) <= 1e-9 * u.length() * v.length();
+            l.mat = mat;
+            lights.push_back(l);
+        }
+
+        bool empty() const { return lights.empty(); }
+        size_t size() const { return lights.size(); }
+
+        // samples a direction from origin towards one of the lights, false if there is none to sample
+        bool sample(const point3& origin, double time, const material_table& materials, sampler& s, light_sample& ls) const {
+            if (lights.empty())
+                return false;
+
+            auto index = std::min(static_cast<size_t>(s.get_1d() * lights.size()), lights.size() - 1);
+            const light& l = lights[index];
+
+            hit_record rec;
+            bool ok = (l.kind == light_kind::sphere) ? sample_sphere(l, origin, time, s, ls, rec)
+                                                     : sample_quad(l, origin, s, ls, rec);
+            if (!ok || !(ls.pdf > 0))
+                return false;
+
+            ls.pdf /= static_cast<double>(lights.size());
+            rec.mat = l.mat;
+            ls.radiance = materials.emitted(rec);
+            return true;
+        }
+
+        // density of sample() for the direction from origin, in solid angle
+        double pdf(const point3& origin, const vec3& direction, double time) const {
+            if (lights.empty())
+                return 0;
+
+            vec3 dir = unit_vector(direction);
+            double sum = 0;
+            for (const auto& l : lights)
+                sum += (l.kind == light_kind::sphere) ? sphere_pdf(l, origin, dir, time) : quad_pdf(l, origin, dir);
+            return sum / static_cast<double>(lights.size());
+        }
+
+    private:
+        enum class light_kind { sphere, quad };
+
+        struct light {
+            light_kind kind;
+            point3 origin;          // sphere center at time 0, or the quad corner Q
+            vec3 edge_u, edge_v;    // sphere velocity, or the quad edges u and v
+            vec3 normal, w;
+            double radius = 0;
+            double area = 0;
+            bool rectangle = false;
+            material_id mat = 0;
+        };
+
+        // the spherical rectangle seen from a point, after Urena et al. 2013
+        struct spherical_rectangle {
+            vec3 x, y, z;
+            double z0, x0, y0, x1, y1;
+            double b0, b1, k;
+            double solid_angle;
+        };
+
+        // below this solid angle the spherical rectangle loses precision and area sampling is used instead
+        static constexpr double min_solid_angle = 1e-4;
+
+        std::vector<light> lights;
+
+        static vec3 any_perpendicular(const vec3& n) {
+            return std::fabs(n.x()) > 0.9 ? unit_vector(cross(n, vec3(0, 1, 0))) : unit_vector(cross(n, vec3(1, 0, 0)));
+        }
+
+        // 1 - sqrt(1 - x) without cancellation for small x
+        static double one_minus_sqrt_one_minus(double x) {
+            return x / (1 + std::sqrt(1 - x));
+        }
+
+        bool sample_sphere(const light& l, const point3& origin, double time, sampler& s, light_sample& ls, hit_record& rec) const {
+            point3 center = l.origin + time * l.edge_u;
+            vec3 to_center = center - origin;
+            double dist2 = to_center.length_squared();
+            double r2 = l.radius * l.radius;
+
+            vec3 dir;
+            if (dist2 <= r2) {
+                // inside the light, every direction reaches it
+                dir = random_unit_vector(s);
+                ls.pdf = 1 / (4 * pi);
+            } else {
+                double one_minus_cos_max = one_minus_sqrt_one_minus(r2 / dist2);
+                double cos_theta = 1 - s.get_1d() * one_minus_cos_max;
+                double sin_theta = std::sqrt(std::fmax(0.0, 1 - cos_theta * cos_theta));
+                double phi = 2 * pi * s.get_1d();
+
+                vec3 axis = to_center / std::sqrt(dist2);
+                vec3 t = any_perpendicular(axis);
+                vec3 b = cross(axis, t);
+                dir = unit_vector(cos_theta * axis + sin_theta * (std::cos(phi) * t + std::sin(phi) * b));
+                ls.pdf = 1 / (2 * pi * one_minus_cos_max);
+            }
+
+            // nearest intersection in front of origin; grazing directions at the cone edge may round to a miss
+            double h = dot(to_center, dir);
+            double discriminant = std::fmax(0.0, h * h - (dist2 - r2));
+            double sqrtd = std::sqrt(discriminant);
+            double t_hit = (h - sqrtd > 0) ? h - sqrtd : h + sqrtd;
+            if (!(t_hit > 0))
+                return false;
+
+            ls.direction = dir;
+            ls.distance = t_hit;
+            rec.p = origin + t_hit * dir;
+            vec3 outward_normal = (rec.p - center) / l.radius;
+            sphere::get_sphere_uv(outward_normal, rec.u, rec.v);
+            return true;
+        }
+
+        double sphere_pdf(const light& l, const point3& origin, const vec3& dir, double time) const {
+            point3 center = l.origin + time * l.edge_u;
+            vec3 to_center = center - origin;
+            double dist2 = to_center.length_squared();
+            double r2 = l.radius * l.radius;
+            if (dist2 <= r2)
+                return 1 / (4 * pi);
+
+            double h = dot(to_center, dir);
+            if (h <= 0 || h * h - (dist2 - r2) < 0)
+                return 0;
+            return 1 / (2 * pi * one_minus_sqrt_one_minus(r2 / dist2));
+        }
+
+        static spherical_rectangle make_spherical_rectangle(const light& l, const point3& origin) {
+            spherical_rectangle sr;
+            double ex_len = l.edge_u.length();
+            double ey_len = l.edge_v.length();
+            sr.x = l.edge_u / ex_len;
+            sr.y = l.edge_v / ey_len;
+            sr.z = cross(sr.x, sr.y);
+
+            vec3 d = l.origin - origin;
+            sr.z0 = dot(d, sr.z);
+            if (sr.z0 > 0) {
+                sr.z = -sr.z;
+                sr.z0 = -sr.z0;
+            }
+            sr.x0 = dot(d, sr.x);
+            sr.y0 = dot(d, sr.y);
+            sr.x1 = sr.x0 + ex_len;
+            sr.y1 = sr.y0 + ey_len;
+
+            // normals of the four planes through origin and an edge, in the (x, y, z) frame
+            vec3 n0 = unit_vector(vec3(0, sr.z0, -sr.y0));
+            vec3 n1 = unit_vector(vec3(-sr.z0, 0, sr.x1));
+            vec3 n2 = unit_vector(vec3(0, -sr.z0, sr.y1));
+            vec3 n3 = unit_vector(vec3(sr.z0, 0, -sr.x0));
+
+            double g0 = std::acos(std::clamp<double>(-dot(n0, n1), -1.0, 1.0));
+            double g1 = std::acos(std::clamp<double>(-dot(n1, n2), -1.0, 1.0));
+            double g2 = std::acos(std::clamp<double>(-dot(n2, n3), -1.0, 1.0));
+            double g3 = std::acos(std::clamp<double>(-dot(n3, n0), -1.0, 1.0));
+
+            sr.b0 = n0.z();
+            sr.b1 = n2.z();
+            sr.k = 2 * pi - g2 - g3;
+            sr.solid_angle = g0 + g1 - sr.k;
+            return sr;
+        }
+
+        static bool use_spherical_rectangle(const light& l, const spherical_rectangle& sr) {
+            return l.rectangle && sr.z0 < 0 && sr.solid_angle > min_solid_angle;
+        }
+
+        bool sample_quad(const light& l, const point3& origin, sampler& s, light_sample& ls, hit_record& rec) const {
+            double su = s.get_1d();
+            double sv = s.get_1d();
+
+            point3 p;
+            spherical_rectangle sr;
+            bool spherical = l.rectangle;
+            if (spherical) {
+                sr = make_spherical_rectangle(l, origin);
+                spherical = use_spherical_rectangle(l, sr);
+            }
+
+            if (spherical) {
+                double au = su * sr.solid_angle + sr.k;
+                double fu = (std::cos(au) * sr.b0 - sr.b1) / std::sin(au);
+                double cu = std::clamp((fu > 0 ? 1.0 : -1.0) / std::sqrt(fu * fu + sr.b0 * sr.b0), -1.0, 1.0);
+                double xu = std::clamp(-(cu * sr.z0) / std::sqrt(std::fmax(1e-12, 1 - cu * cu)), sr.x0, sr.x1);
+
+                double d = std::sqrt(xu * xu + sr.z0 * sr.z0);
+                double h0 = sr.y0 / std::sqrt(d * d + sr.y0 * sr.y0);
+                double h1 = sr.y1 / std::sqrt(d * d + sr.y1 * sr.y1);
+                double hv = h0 + sv * (h1 - h0);
+                double hv2 = hv * hv;
+                double yv = (hv2 < 1 - 1e-12) ? (hv * d) / std::sqrt(1 - hv2) : sr.y1;
+
+                p = origin + xu * sr.x + yv * sr.y + sr.z0 * sr.z;
+                ls.pdf = 1 / sr.solid_angle;
+            } else {
+                p = l.origin + su * l.edge_u + sv * l.edge_v;
+            }
+
+            vec3 to_light = p - origin;
+            double dist = to_light.length();
+            if (!(dist > 0))
+                return false;
+
+            ls.direction = to_light / dist;
+            ls.distance = dist;
+
+            if (!spherical) {
+                double cosine = std::fabs(dot(l.normal, ls.direction));
+                if (cosine < 1e-8)
+                    return false;
+                ls.pdf = dist * dist / (cosine * l.area);
+            }
+
+            vec3 planar = p - l.origin;
+            rec.p = p;
+            rec.u = std::clamp<double>(dot(l.w, cross(planar, l.edge_v)), 0.0, 1.0);
+            rec.v = std::clamp<double>(dot(l.edge_u, cross(planar, l.w)), 0.0, 1.0);
+            return true;
+        }
+
+        double quad_pdf(const light& l, const point3& origin, const vec3& dir) const {
+            double denom = dot(l.normal, dir);
+            if (std::fabs(denom) < 1e-8)
+                return 0;
+
+            double t = dot(l.normal, l.origin - origin) / denom;
+            if (t <= 0)
+                return 0;
+
+            vec3 planar = origin + t * dir - l.origin;
+            double alpha = dot(l.w, cross(planar, l.edge_v));
+            double beta = dot(l.edge_u, cross(planar, l.w));
+            if (alpha < 0 || alpha > 1 || beta < 0 || beta > 1)
+                return 0;
+
+            if (l.rectangle) {
+                auto sr = make_spherical_rectangle(l, origin);
+                if (use_spherical_rectangle(l, sr))
+                    return 1 / sr.solid_angle;
+            }
+            return t * t / (std::fabs(denom) * l.area);
+        }
+    };
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "aabb.h"
+#include "bvh_builder.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include <cstdint>
+#include <vector>
+
+namespace My
+{
+    // bvh flattened into one contiguous array of 32-byte nodes, with the primitives reordered to match leaf order.
+    // traversal is iterative, visits the nearer child first and shrinks ray_t.max on every hit
+    class linear_bvh : public hittable
+    {
+    public:
+        linear_bvh(const hittable_list& list, const bvh_builder& builder = bvh_builder()) {
+            std::vector<aabb> bounds;
+            bounds.reserve(list.objects.size());
+            for (const auto& object : list.objects)
+                bounds.push_back(object->bounding_box());
+
+            std::vector<uint32_t> order;
+            nodes = builder.build(bounds, order, &stats);
+
+            primitives.reserve(order.size());
+            for (auto index : order)
+                primitives.push_back(list.objects[index]);
+
+            bbox = list.bounding_box();
+        }
+
+        bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            const point3& origin = r.origin();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            bool hit_anything = false;
+
+            traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const linear_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, ray_t.min, ray_t.max); },
+                [&](const linear_bvh_node& node) {
+                    for (uint32_t i = 0; i < node.count; i++) {
+                        if (primitives[node.offset + i]->hit(r, ray_t, rec, s)) {
+                            hit_anything = true;
+                            ray_t.max = rec.t;
+                        }
+                    }
+                    return false;
+                });
+
+            return hit_anything;
+        }
+
+        // same traversal as hit, returning at the first primitive that blocks the ray
+        bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            const point3& origin = r.origin();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            return traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const linear_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, ray_t.min, ray_t.max); },
+                [&](const linear_bvh_node& node) {
+                    for (uint32_t i = 0; i < node.count; i++) {
+                        if (primitives[node.offset + i]->occluded(r, ray_t, s))
+                            return true;
+                    }
+                    return false;
+                });
+        }
+
+        aabb bounding_box() const override { return bbox; }
+
+        size_t node_count() const { return nodes.size(); }
+
+        const bvh_build_stats& build_stats() const { return stats; }
+
+    private:
+        std::vector<linear_bvh_node> nodes;
+        std::vector<shared_ptr<hittable>> primitives;
+        aabb bbox;
+        bvh_build_stats stats;
+    };
+}
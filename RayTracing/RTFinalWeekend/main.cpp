@@ -1,66 +1,283 @@
-#include "rtweekend.h"
-
-#include "bvh.h"
-#include "camera.h"
-#include "hittable.h"
-#include "hittable_list.h"
-#include "material.h"
-#include "sphere.h"
-#include "texture.h"
-#include "quad.h"
-#include "constant_medium.h"
-
-#include <chrono>
-
-using namespace My;
-
-int main() {
-    hittable_list world;
-
-    auto red = make_shared<lambertian>(color(.65, 0.05, 0.05));
-    auto white = make_shared<lambertian>(color(.73, .73, .73));
-    auto green = make_shared<lambertian>(color(0.12, 0.45, 0.15));
-    auto light = make_shared<diffuse_light>(color(15, 15, 15));
-
-    world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 0, 555), vec3(0, 555, 0), green));
-    world.add(make_shared<quad>(point3(0, 0, 555), vec3(0, 0, -555), vec3(0, 555, 0), red));
-    world.add(make_shared<quad>(point3(0, 555, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
-    world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 0, -555), white));
-    world.add(make_shared<quad>(point3(555, 0, 555), vec3(-555, 0, 0), vec3(0, 555, 0), white));
-
-    world.add(make_shared<quad>(point3(213, 554, 227), vec3(130, 0, 0), vec3(0, 0, 105), light));
-
-    shared_ptr<hittable> box1 = box(point3(0, 0, 0), point3(165, 330, 165), white);
-    box1 = make_shared<rotate_y>(box1, 15);
-    box1 = make_shared<translate>(box1, vec3(265, 0, 295));
-    world.add(box1);
-
-    shared_ptr<hittable> box2 = box(point3(0, 0, 0), point3(165, 165, 165), white);
-    box2 = make_shared<rotate_y>(box2, -18);
-    box2 = make_shared<translate>(box2, vec3(130, 0, 65));
-    world.add(box2);
-
-    camera cam;
-
-    cam.aspect_ratio = 1.0;
-    cam.image_width = 600;
-    cam.samples_per_pixel = 64;
-    cam.max_depth = 50;
-    cam.background = color(0.0, 0.0, 0.0);
-
-    cam.vfov = 40;
-    cam.lookfrom = point3(278, 278, -800);
-    cam.lookat = point3(278, 278, 0);
-    cam.vup = vec3(0, 1, 0);
-
-    cam.defocus_angle = 0;
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    cam.render(world);
-
-    auto end = std::chrono::high_resolution_clock::now();
-
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start);
-    std::clog << "Elapsed time: " << duration.count() << " seconds" << std::endl;
-}
+#include "rtweekend.h"
+
+#include "checkpoint.h"
+#include "image_writer.h"
+#include "scenes.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+using namespace My;
+
+static void print_usage() {
+    std::cerr << "usage: RayTracing [--scene 1-12] [--obj FILE] [--accel bvh_node|linear_bvh|sah_bvh|bvh4|soa_bvh|motion_bvh] [--threads N] [--width N] [--spp N]\n"
+              << "                  [--integrator recursive|iterative] [--rr-depth N] [--nee on|off] [--seed N]\n"
+              << "                  [--sampler independent|stratified|halton|sobol]\n"
+              << "                  [--output FILE] [--format p3|p6|pfm|hdr]\n"
+              << "                  [--pass-spp N] [--checkpoint FILE] [--checkpoint-every SECONDS]\n"
+              << "                  [--adaptive THRESHOLD] [--adaptive-min-passes N] [--heatmap FILE]\n"
+              << "                  [--texture-budget MB] [--cost-image FILE]\n"
+              << "--obj renders the triangles of a wavefront obj file in the cornell box.\n"
+              << "the image goes to stdout unless --output is given, the format defaults to the file extension or p6.\n"
+              << "--pass-spp or --checkpoint render progressively in passes of N spp up to --spp, resuming from and\n"
+              << "saving to the checkpoint file. --adaptive stops sampling pixels whose relative error is below the\n"
+              << "threshold, --spp is then the most a pixel gets; --heatmap writes the samples spent per pixel\n"
+              << "image textures are converted once to tiled files in $RTW_TEXTURE_CACHE (default: the temp directory)\n"
+              << "and read a tile at a time, keeping at most --texture-budget MB of tiles mapped (default 64)\n"
+              << "--cost-image writes the node visits and primitive tests per sample of every pixel, in a build with\n"
+              << "RT_COUNTERS, which also reports the counts after the render\n";
+}
+
+struct progressive_options {
+    std::string checkpoint;
+    double checkpoint_seconds = 60;
+    std::string heatmap;
+};
+
+// renders passes until the camera's samples_per_pixel is reached, saving the accumulation buffer every
+// checkpoint_seconds and after the last pass. a file output also gets a preview image at every checkpoint
+static bool render_progressive(scene& sc, uint64_t scene_key, const progressive_options& options, image_writer& writer,
+                               const std::string& output, image_format format) {
+    accumulation_buffer accum;
+    uint64_t key = mix_bits(sc.cam.progressive_key() ^ scene_key);
+
+    if (!options.checkpoint.empty()) {
+        auto status = load_checkpoint(options.checkpoint, key, sc.cam.image_width, sc.cam.output_height(), accum);
+        if (status == checkpoint_status::rejected)
+            return false;
+        if (status == checkpoint_status::loaded)
+            std::clog << "Resuming from " << options.checkpoint << " after " << accum.passes() << " passes ("
+                      << static_cast<double>(accum.total_samples()) / accum.pixel_count() << " spp)" << std::endl;
+    }
+
+    int pass_samples = sc.cam.pass_samples();
+    uint32_t target_passes = static_cast<uint32_t>((sc.cam.samples_per_pixel + pass_samples - 1) / pass_samples);
+    bool preview = !output.empty() && output != "-";
+    auto last_save = std::chrono::steady_clock::now();
+
+    while (accum.passes() < target_passes) {
+        sc.cam.render_pass(sc.world, sc.materials, sc.lights, accum);
+
+        bool last = accum.passes() == target_passes;
+        std::chrono::duration<double> since_save = std::chrono::steady_clock::now() - last_save;
+        if (!options.checkpoint.empty() && (last || since_save.count() >= options.checkpoint_seconds)) {
+            if (!save_checkpoint(options.checkpoint, key, accum))
+                return false;
+            std::clog << "Checkpoint saved after " << accum.passes() << " passes" << std::endl;
+            last_save = std::chrono::steady_clock::now();
+            if (preview && !last)
+                writer.write(accum.resolve(), output, format);
+        }
+    }
+
+    writer.write(accum.resolve(), output, format);
+    if (!options.heatmap.empty())
+        writer.write(accum.sample_heatmap(), options.heatmap, image_format_for_path(options.heatmap));
+
+    std::clog << "Samples: " << accum.total_samples() << ", " << static_cast<double>(accum.total_samples()) / accum.pixel_count()
+              << " per pixel on average" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int scene_id = 7;
+    std::string obj_path;
+    int thread_count = 0;
+    int image_width = 0;
+    int samples_per_pixel = 0;
+    accel_type accel = accel_type::sah_bvh;
+    integrator_type integrator = integrator_type::iterative;
+    int rr_min_depth = -1;
+    bool next_event = true;
+    uint64_t seed = 0;
+    sampler_type sampling = sampler_type::sobol;
+    std::string output;
+    image_format format = image_format::p6;
+    bool format_given = false;
+    bool progressive = false;
+    int pass_spp = 0;
+    double adaptive_threshold = 0;
+    int adaptive_min_passes = -1;
+    progressive_options options;
+    double texture_budget_mb = -1;
+    std::string cost_image;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--scene") == 0 && has_value) {
+            scene_id = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--obj") == 0 && has_value) {
+            obj_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--accel") == 0 && has_value) {
+            if (!parse_accel(argv[++i], accel)) {
+                print_usage();
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            thread_count = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--width") == 0 && has_value) {
+            image_width = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spp") == 0 && has_value) {
+            samples_per_pixel = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--integrator") == 0 && has_value) {
+            ++i;
+            if (std::strcmp(argv[i], "recursive") == 0) {
+                integrator = integrator_type::recursive;
+            } else if (std::strcmp(argv[i], "iterative") == 0) {
+                integrator = integrator_type::iterative;
+            } else {
+                print_usage();
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--rr-depth") == 0 && has_value) {
+            rr_min_depth = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--nee") == 0 && has_value) {
+            next_event = std::strcmp(argv[++i], "off") != 0;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--sampler") == 0 && has_value) {
+            if (!parse_sampler(argv[++i], sampling)) {
+                print_usage();
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--output") == 0 && has_value) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--format") == 0 && has_value) {
+            if (!parse_image_format(argv[++i], format)) {
+                print_usage();
+                return 1;
+            }
+            format_given = true;
+        } else if (std::strcmp(argv[i], "--pass-spp") == 0 && has_value) {
+            pass_spp = std::atoi(argv[++i]);
+            progressive = true;
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && has_value) {
+            options.checkpoint = argv[++i];
+            progressive = true;
+        } else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && has_value) {
+            options.checkpoint_seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--adaptive") == 0 && has_value) {
+            adaptive_threshold = std::atof(argv[++i]);
+            progressive = true;
+        } else if (std::strcmp(argv[i], "--adaptive-min-passes") == 0 && has_value) {
+            adaptive_min_passes = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--heatmap") == 0 && has_value) {
+            options.heatmap = argv[++i];
+            progressive = true;
+        } else if (std::strcmp(argv[i], "--texture-budget") == 0 && has_value) {
+            texture_budget_mb = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cost-image") == 0 && has_value) {
+            cost_image = argv[++i];
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!format_given && !output.empty())
+        format = image_format_for_path(output);
+
+    if (!cost_image.empty() && !counters_enabled) {
+        std::cerr << "ERROR: --cost-image needs a build with RT_COUNTERS (cmake -DRT_COUNTERS=ON).\n";
+        return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    scene sc;
+    uint64_t scene_key = static_cast<uint64_t>(scene_id);
+    if (!obj_path.empty()) {
+        if (!obj_scene(obj_path, accel, sc))
+            return 1;
+        scene_key = 0;
+        for (char c : obj_path)
+            scene_key = mix_bits(scene_key ^ static_cast<unsigned char>(c));
+    } else {
+        switch (scene_id) {
+            case 1: sc = bouncing_spheres(accel); break;
+            case 2: sc = checkered_spheres(accel); break;
+            case 3: sc = earth(accel); break;
+            case 4: sc = perlin_noise(accel); break;
+            case 5: sc = quads(accel); break;
+            case 6: sc = simple_light(accel); break;
+            case 7: sc = cornell_box(accel); break;
+            case 8: sc = cornell_smoke(accel); break;
+            case 9: sc = final_scene(800, 10000, 40, accel); break;
+            case 11: sc = instanced_field(100000, accel); break;
+            case 12: sc = cornell_cloud(accel); break;
+            default: sc = final_scene(400, 250, 4, accel); break;
+        }
+    }
+
+    auto built = std::chrono::high_resolution_clock::now();
+    std::clog << "Scene built with " << accel_name(accel) << " in "
+              << std::chrono::duration<double, std::milli>(built - start).count() << " ms" << std::endl;
+
+    if (auto bvh = std::dynamic_pointer_cast<linear_bvh>(sc.world.objects[0])) {
+        const auto& stats = bvh->build_stats();
+        std::clog << "Top-level bvh: " << stats.node_count << " nodes, " << stats.leaf_count << " leaves, depth "
+                  << stats.max_depth << ", sah cost " << stats.sah_cost << ", built in " << stats.build_ms << " ms" << std::endl;
+    } else if (auto motion = std::dynamic_pointer_cast<motion_bvh>(sc.world.objects[0])) {
+        const auto& stats = motion->build_stats();
+        std::clog << "Top-level motion bvh: " << stats.node_count << " nodes, " << stats.leaf_count << " leaves, depth "
+                  << stats.max_depth << ", time-averaged sah cost " << stats.sah_cost << ", built in " << stats.build_ms << " ms" << std::endl;
+    } else if (auto wide = std::dynamic_pointer_cast<bvh4>(sc.world.objects[0])) {
+        const auto& stats = wide->build_stats();
+        std::clog << "Top-level bvh4: " << wide->node_count() << " wide nodes from " << stats.node_count
+                  << " binary nodes, sah cost " << stats.sah_cost << ", built in " << stats.build_ms << " ms" << std::endl;
+    } else if (auto store = std::dynamic_pointer_cast<geometry_store>(sc.world.objects[0])) {
+        const auto& stats = store->build_stats();
+        std::clog << "Geometry store: " << store->sphere_count() << " spheres, " << store->quad_count() << " quads, "
+                  << store->object_count() << " objects, " << stats.node_count << " nodes, built in " << stats.build_ms << " ms" << std::endl;
+    }
+
+    if (texture_budget_mb >= 0)
+        sc.materials.textures.cache().set_budget(static_cast<size_t>(texture_budget_mb * (1 << 20)));
+
+    sc.cam.thread_count = thread_count;
+    if (image_width > 0) sc.cam.image_width = image_width;
+    if (samples_per_pixel > 0) sc.cam.samples_per_pixel = samples_per_pixel;
+    sc.cam.integrator = integrator;
+    if (rr_min_depth >= 0) sc.cam.rr_min_depth = rr_min_depth;
+    sc.cam.next_event = next_event;
+    sc.cam.seed = seed;
+    sc.cam.sampling = sampling;
+    if (pass_spp > 0) sc.cam.pass_spp = pass_spp;
+    sc.cam.adaptive_threshold = adaptive_threshold;
+    if (adaptive_min_passes >= 0) sc.cam.adaptive_min_passes = adaptive_min_passes;
+    std::clog << "Sampler: " << sampler_name(sampling) << std::endl;
+    if (sizeof(real) == sizeof(float))
+        std::clog << "Precision: float storage, double intersection math" << std::endl;
+    std::clog << "Lights: " << sc.lights.size() << (next_event ? "" : " (not sampled)") << std::endl;
+
+    image_writer writer;
+    bool rendered = true;
+    if (progressive) {
+        rendered = render_progressive(sc, scene_key, options, writer, output, format);
+        if (counters_enabled)
+            sc.cam.print_counters();
+    } else {
+        writer.write(sc.cam.render(sc.world, sc.materials, sc.lights), output, format);
+    }
+    if (!cost_image.empty())
+        writer.write(sc.cam.cost_image(), cost_image, image_format_for_path(cost_image));
+    bool written = writer.wait() && rendered;
+
+    auto tiles = sc.materials.textures.cache().stats();
+    if (tiles.hits + tiles.misses > 0) {
+        std::clog << "Texture cache: " << tiles.hits << " hits, " << tiles.misses << " misses ("
+                  << 100.0 * tiles.hits / (tiles.hits + tiles.misses) << "% hits), " << tiles.evictions << " evictions, peak "
+                  << tiles.peak_bytes / 1024 << " of " << tiles.budget_bytes / 1024 << " KiB";
+        if (tiles.map_failures > 0)
+            std::clog << ", " << tiles.map_failures << " failed mappings";
+        std::clog << std::endl;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double> duration = end - start;
+    std::clog << "Elapsed time: " << duration.count() << " seconds" << std::endl;
+
+    return written ? 0 : 1;
+}
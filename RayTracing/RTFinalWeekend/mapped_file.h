@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace My
+{
+    // a whole file mapped into memory, read only or read write
+    class mapped_file
+    {
+    public:
+        mapped_file() = default;
+        ~mapped_file() { close(); }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        // creates (or truncates) path with size bytes and maps it for writing
+        bool create(const std::string& path, size_t size) {
+            close();
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                         static_cast<DWORD>(size), nullptr);
+            if (!mapping) {
+                close();
+                return false;
+            }
+            bytes = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size));
+#else
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+                return false;
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                close();
+                return false;
+            }
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            bytes = p == MAP_FAILED ? nullptr : static_cast<char*>(p);
+#endif
+            length = size;
+            if (!bytes) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+                close();
+                return false;
+            }
+            length = static_cast<size_t>(file_size.QuadPart);
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) {
+                close();
+                return false;
+            }
+            bytes = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+                close();
+                return false;
+            }
+            length = static_cast<size_t>(st.st_size);
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            bytes = p == MAP_FAILED ? nullptr : static_cast<char*>(p);
+#endif
+            if (!bytes) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        // writes the mapped pages back to the file
+        bool flush() {
+#ifdef _WIN32
+            return bytes && FlushViewOfFile(bytes, 0) && FlushFileBuffers(file);
+#else
+            return bytes && ::msync(bytes, length, MS_SYNC) == 0;
+#endif
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (bytes) UnmapViewOfFile(bytes);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (bytes) ::munmap(bytes, length);
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+
+        char* data() { return bytes; }
+        const char* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        char* bytes = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+
+    // a read-only mapping of part of a file, unmapped when destroyed
+    class mapped_view
+    {
+    public:
+        mapped_view() = default;
+        ~mapped_view() { reset(); }
+
+        mapped_view(const mapped_view&) = delete;
+        mapped_view& operator=(const mapped_view&) = delete;
+
+        mapped_view(mapped_view&& other) noexcept { *this = std::move(other); }
+
+        mapped_view& operator=(mapped_view&& other) noexcept {
+            if (this != &other) {
+                reset();
+                base = other.base;
+                length = other.length;
+                bytes = other.bytes;
+                other.base = nullptr;
+                other.length = 0;
+                other.bytes = nullptr;
+            }
+            return *this;
+        }
+
+        const char* data() const { return bytes; }
+        explicit operator bool() const { return bytes != nullptr; }
+
+    private:
+        friend class paged_file;
+
+        void* base = nullptr;           // of the mapping, which starts at an aligned offset before bytes
+        size_t length = 0;
+        const char* bytes = nullptr;
+
+        void reset() {
+#ifdef _WIN32
+            if (base) UnmapViewOfFile(base);
+#else
+            if (base) ::munmap(base, length);
+#endif
+            base = nullptr;
+            length = 0;
+            bytes = nullptr;
+        }
+    };
+
+    // a read-only file that is mapped a piece at a time, for files that should not be resident as a whole.
+    // a piece may start at any offset, its mapping starts at the page (on windows the allocation
+    // granularity) below it. views stay valid after the file is closed
+    class paged_file
+    {
+    public:
+        paged_file() = default;
+        ~paged_file() { close(); }
+
+        paged_file(const paged_file&) = delete;
+        paged_file& operator=(const paged_file&) = delete;
+
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+                close();
+                return false;
+            }
+            length = static_cast<size_t>(file_size.QuadPart);
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) {
+                close();
+                return false;
+            }
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+                close();
+                return false;
+            }
+            length = static_cast<size_t>(st.st_size);
+#endif
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            length = 0;
+        }
+
+        bool is_open() const { return length > 0; }
+        size_t size() const { return length; }
+
+        // maps [offset, offset + count), an empty view if that is not inside the file or the mapping fails
+        mapped_view map(size_t offset, size_t count) const {
+            mapped_view view;
+            if (!is_open() || count == 0 || offset > length || count > length - offset)
+                return view;
+
+            size_t start = offset - offset % granularity();
+            size_t span = offset - start + count;
+#ifdef _WIN32
+            view.base = MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(static_cast<uint64_t>(start) >> 32),
+                                      static_cast<DWORD>(start), span);
+#else
+            void* p = ::mmap(nullptr, span, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(start));
+            view.base = p == MAP_FAILED ? nullptr : p;
+#endif
+            if (view.base) {
+                view.length = span;
+                view.bytes = static_cast<const char*>(view.base) + (offset - start);
+            }
+            return view;
+        }
+
+        static size_t granularity() {
+#ifdef _WIN32
+            static const size_t size = [] {
+                SYSTEM_INFO info;
+                GetSystemInfo(&info);
+                return static_cast<size_t>(info.dwAllocationGranularity);
+            }();
+#else
+            static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+            return size;
+        }
+
+    private:
+        size_t length = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+    };
+
+    // moves from over to, replacing any file there in one step: a crash leaves either the old file or the new one.
+    // rename does that on posix; on windows it fails if to exists, and removing it first would open a gap
+    inline bool replace_file(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include "aabb.h"
+#include "bvh_builder.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include <cstdint>
+#include <vector>
+
+namespace My
+{
+    // a flat bvh node with its bounds at both ends of the shutter. the box at a ray's time is interpolated
+    // between them, which for linearly moving primitives is as tight as the box of a still frame
+    struct motion_bvh_node
+    {
+        float bounds[2][3];       // min and max corner at time 0
+        float motion[2][3];       // change of the corners from time 0 to 1
+        uint32_t offset;          // leaf: first primitive, interior: second child
+        uint16_t count;           // primitives in the leaf, 0 for interior nodes
+        uint8_t axis;             // split axis of interior nodes
+        uint8_t pad;
+
+        bool is_leaf() const { return count > 0; }
+
+        // the interpolated box is linear in time, so it contains the true one at every time
+        // as long as it does at both ends; the deltas are nudged until the far end holds
+        void set_bounds(const aabb& at0, const aabb& at1) {
+            const float inf = std::numeric_limits<float>::infinity();
+            for (int a = 0; a < 3; a++) {
+                bounds[0][a] = linear_bvh_node::round_down(at0.axis_interval(a).min);
+                bounds[1][a] = linear_bvh_node::round_up(at0.axis_interval(a).max);
+                double lo = at1.axis_interval(a).min, hi = at1.axis_interval(a).max;
+                motion[0][a] = static_cast<float>(lo - bounds[0][a]);
+                while (static_cast<double>(bounds[0][a]) + motion[0][a] > lo)
+                    motion[0][a] = std::nextafter(motion[0][a], -inf);
+                motion[1][a] = static_cast<float>(hi - bounds[1][a]);
+                while (static_cast<double>(bounds[1][a]) + motion[1][a] < hi)
+                    motion[1][a] = std::nextafter(motion[1][a], inf);
+            }
+        }
+
+        aabb bounds_at(double time) const {
+            point3 lo, hi;
+            for (int a = 0; a < 3; a++) {
+                lo[a] = bounds[0][a] + time * motion[0][a];
+                hi[a] = bounds[1][a] + time * motion[1][a];
+            }
+            return aabb(lo, hi);
+        }
+
+        // the slab test of linear_bvh_node against the box at time
+        bool hit(const point3& origin, const vec3& inv_dir, const int dir_is_neg[3], double time, double tmin, double tmax) const {
+            RT_COUNT(box_tests);
+            for (int a = 0; a < 3; a++) {
+                double lo = bounds[0][a] + time * motion[0][a];
+                double hi = bounds[1][a] + time * motion[1][a];
+                double t0 = ((dir_is_neg[a] ? hi : lo) - origin[a]) * inv_dir[a];
+                double t1 = ((dir_is_neg[a] ? lo : hi) - origin[a]) * inv_dir[a];
+                if (t0 > tmin) tmin = t0;
+                if (t1 < tmax) tmax = t1;
+            }
+            return tmin <= tmax * (1 + 4 * std::numeric_limits<double>::epsilon());
+        }
+    };
+
+    static_assert(sizeof(motion_bvh_node) == 56, "motion_bvh_node should stay 56 bytes");
+
+    // linear_bvh for scenes with moving primitives. a moving sphere's bounding box is the union over the whole
+    // shutter, so a static bvh sees every moving primitive stretched along its path and tests it for rays of any
+    // time. here the tree is built over the boxes at mid shutter and then refit with the boxes at both ends;
+    // traversal interpolates the node bounds to the ray's time. that makes a node test about a third dearer than
+    // a static one, so it pays where primitives move far compared to their size
+    class motion_bvh : public hittable
+    {
+    public:
+        motion_bvh(const hittable_list& list, const bvh_builder& builder = bvh_builder()) {
+            size_t count = list.objects.size();
+            std::vector<aabb> mid(count), at0(count), at1(count);
+            for (size_t i = 0; i < count; i++) {
+                at0[i] = list.objects[i]->bounds_at(0);
+                at1[i] = list.objects[i]->bounds_at(1);
+                mid[i] = list.objects[i]->bounds_at(0.5);
+            }
+
+            std::vector<uint32_t> order;
+            std::vector<linear_bvh_node> tree = builder.build(mid, order, &stats);
+
+            primitives.reserve(order.size());
+            for (auto index : order)
+                primitives.push_back(list.objects[index]);
+
+            // children come after their parent, so one backwards sweep refits every node from its children
+            nodes.resize(tree.size());
+            for (size_t i = tree.size(); i-- > 0;) {
+                const linear_bvh_node& node = tree[i];
+                aabb box0 = aabb::empty, box1 = aabb::empty;
+                if (node.is_leaf()) {
+                    for (uint32_t k = node.offset; k < node.offset + node.count; k++) {
+                        box0 = aabb(box0, at0[order[k]]);
+                        box1 = aabb(box1, at1[order[k]]);
+                    }
+                } else {
+                    for (size_t child : { i + 1, static_cast<size_t>(node.offset) }) {
+                        box0 = aabb(box0, nodes[child].bounds_at(0));
+                        box1 = aabb(box1, nodes[child].bounds_at(1));
+                    }
+                }
+                nodes[i].set_bounds(box0, box1);
+                nodes[i].offset = node.offset;
+                nodes[i].count = node.count;
+                nodes[i].axis = node.axis;
+                nodes[i].pad = 0;
+            }
+
+            bbox = list.bounding_box();
+
+            // the sah cost over the time-averaged node areas, relative to the box over the whole shutter so it
+            // compares with a linear_bvh over the same list. the area of the interpolated box is quadratic in
+            // time, which simpson's rule averages exactly
+            stats.sah_cost = 0;
+            double root_area = bbox.surface_area();
+            for (const auto& node : nodes) {
+                double area = (node.bounds_at(0).surface_area() + 4 * node.bounds_at(0.5).surface_area() +
+                               node.bounds_at(1).surface_area()) / 6;
+                double p = root_area > 0 ? area / root_area : 1;
+                stats.sah_cost += builder.traversal_cost * p;
+                if (node.is_leaf())
+                    stats.sah_cost += node.count * p;
+            }
+        }
+
+        // true if any of the objects has different bounds at the two ends of the shutter
+        static bool has_motion(const hittable_list& list) {
+            for (const auto& object : list.objects) {
+                aabb at0 = object->bounds_at(0), at1 = object->bounds_at(1);
+                for (int a = 0; a < 3; a++) {
+                    if (at0.axis_interval(a).min != at1.axis_interval(a).min || at0.axis_interval(a).max != at1.axis_interval(a).max)
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            const point3& origin = r.origin();
+            double time = r.time();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            bool hit_anything = false;
+
+            traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const motion_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, time, ray_t.min, ray_t.max); },
+                [&](const motion_bvh_node& node) {
+                    for (uint32_t i = 0; i < node.count; i++) {
+                        if (primitives[node.offset + i]->hit(r, ray_t, rec, s)) {
+                            hit_anything = true;
+                            ray_t.max = rec.t;
+                        }
+                    }
+                    return false;
+                });
+
+            return hit_anything;
+        }
+
+        bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            const point3& origin = r.origin();
+            double time = r.time();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            return traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const motion_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, time, ray_t.min, ray_t.max); },
+                [&](const motion_bvh_node& node) {
+                    for (uint32_t i = 0; i < node.count; i++) {
+                        if (primitives[node.offset + i]->occluded(r, ray_t, s))
+                            return true;
+                    }
+                    return false;
+                });
+        }
+
+        aabb bounding_box() const override { return bbox; }
+
+        aabb bounds_at(double time) const override {
+            return nodes.empty() ? aabb::empty : nodes[0].bounds_at(time);
+        }
+
+        size_t node_count() const { return nodes.size(); }
+
+        const bvh_build_stats& build_stats() const { return stats; }
+
+    private:
+        std::vector<motion_bvh_node> nodes;
+        std::vector<shared_ptr<hittable>> primitives;
+        aabb bbox;
+        bvh_build_stats stats;
+    };
+}
@@ -0,0 +1,335 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include "triangle_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace My
+{
+    namespace obj_detail
+    {
+        inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+        inline void skip_spaces(const char*& p, const char* end) {
+            while (p < end && is_space(*p)) p++;
+        }
+
+        inline const char* line_end(const char* p, const char* end) {
+            auto* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            return nl ? nl : end;
+        }
+
+        // decimal float with an optional fraction and exponent. the digits go into an integer and are scaled by
+        // a power of ten once, which is within an ulp of a double and so exact enough for a float
+        inline bool parse_float(const char*& p, const char* end, float& out) {
+            static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                             1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+            skip_spaces(p, end);
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+            uint64_t mantissa = 0;
+            int exponent = 0;
+            int digits = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+                if (mantissa < 100000000000000000ULL) mantissa = mantissa * 10 + (*p - '0');
+                else exponent++;
+            }
+            if (p < end && *p == '.') {
+                for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+                    if (mantissa < 100000000000000000ULL) {
+                        mantissa = mantissa * 10 + (*p - '0');
+                        exponent--;
+                    }
+                }
+            }
+            if (digits == 0)
+                return false;
+
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                p++;
+                bool negative_exponent = false;
+                if (p < end && (*p == '-' || *p == '+')) negative_exponent = *p++ == '-';
+                int e = 0;
+                for (; p < end && *p >= '0' && *p <= '9'; p++)
+                    e = std::min(e * 10 + (*p - '0'), 1000);
+                exponent += negative_exponent ? -e : e;
+            }
+
+            double value = static_cast<double>(mantissa);
+            if (exponent < -22 || exponent > 22) value *= std::pow(10.0, exponent);
+            else if (exponent < 0) value /= powers[-exponent];
+            else value *= powers[exponent];
+
+            out = static_cast<float>(negative ? -value : value);
+            return true;
+        }
+
+        inline bool parse_int(const char*& p, const char* end, int64_t& out) {
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+            if (p == end || *p < '0' || *p > '9')
+                return false;
+            int64_t value = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p++)
+                value = std::min<int64_t>(value * 10 + (*p - '0'), INT64_C(1) << 40);
+            out = negative ? -value : value;
+            return true;
+        }
+
+        enum class line_kind { other, position, uv, normal, face };
+
+        // p is at the start of a line, after it at the first argument
+        inline line_kind classify(const char*& p, const char* end) {
+            skip_spaces(p, end);
+            if (p + 1 >= end) return line_kind::other;
+            if (p[0] == 'f' && is_space(p[1])) { p += 2; return line_kind::face; }
+            if (p[0] != 'v') return line_kind::other;
+            if (is_space(p[1])) { p += 2; return line_kind::position; }
+            if (p + 2 >= end || !is_space(p[2])) return line_kind::other;
+            if (p[1] == 't') { p += 3; return line_kind::uv; }
+            if (p[1] == 'n') { p += 3; return line_kind::normal; }
+            return line_kind::other;
+        }
+
+        struct chunk
+        {
+            const char* begin;
+            const char* end;
+            size_t positions = 0, uvs = 0, normals = 0;             // lines of each kind in the chunk
+            size_t position_base = 0, uv_base = 0, normal_base = 0; // the same lines in the chunks before
+            std::vector<uint32_t> position_indices, uv_indices, normal_indices;
+            bool has_uvs = false, has_normals = false;
+            const char* error = nullptr;                            // the line that failed to parse
+            const char* reason = nullptr;                           // and what was wrong with it
+        };
+
+        // an obj index to a zero based one: positive indices count from 1, negative ones back from the
+        // last element defined before the line
+        inline bool resolve(int64_t index, size_t defined, size_t total, uint32_t& out) {
+            int64_t i = index > 0 ? index - 1 : static_cast<int64_t>(defined) + index;
+            if (index == 0 || i < 0 || i >= static_cast<int64_t>(total))
+                return false;
+            out = static_cast<uint32_t>(i);
+            return true;
+        }
+
+        // one index of a face corner; an index past what the file defines names its kind in reason
+        inline bool parse_index(const char*& p, const char* end, size_t defined, size_t total, const char* kind,
+                                uint32_t& out, const char*& reason) {
+            int64_t index;
+            if (!parse_int(p, end, index))
+                return false;
+            if (!resolve(index, defined, total, out)) {
+                reason = kind;
+                return false;
+            }
+            return true;
+        }
+
+        inline bool parse_chunk(chunk& c, mesh_data& mesh, size_t total_positions, size_t total_uvs, size_t total_normals) {
+            size_t positions = c.position_base, uvs = c.uv_base, normals = c.normal_base;
+            std::vector<uint32_t> face_p, face_t, face_n;
+
+            for (const char* line = c.begin; line < c.end;) {
+                const char* end = line_end(line, c.end);
+                const char* p = line;
+                bool ok = true;
+
+                switch (classify(p, end)) {
+                    case line_kind::position: {
+                        float* out = &mesh.positions[3 * positions++];
+                        ok = parse_float(p, end, out[0]) && parse_float(p, end, out[1]) && parse_float(p, end, out[2]);
+                        break;
+                    }
+                    case line_kind::uv: {
+                        float* out = &mesh.uvs[2 * uvs++];
+                        ok = parse_float(p, end, out[0]);
+                        const char* before = p;
+                        if (ok && !parse_float(p, end, out[1])) {
+                            p = before;
+                            out[1] = 0;
+                        }
+                        break;
+                    }
+                    case line_kind::normal: {
+                        float* out = &mesh.normals[3 * normals++];
+                        ok = parse_float(p, end, out[0]) && parse_float(p, end, out[1]) && parse_float(p, end, out[2]);
+                        break;
+                    }
+                    case line_kind::face: {
+                        // v, v/vt, v//vn or v/vt/vn per corner
+                        face_p.clear();
+                        face_t.clear();
+                        face_n.clear();
+                        while (ok) {
+                            skip_spaces(p, end);
+                            if (p == end) break;
+                            uint32_t resolved = 0;
+                            ok = parse_index(p, end, positions, total_positions, "position", resolved, c.reason);
+                            face_p.push_back(resolved);
+                            uint32_t uv = mesh_data::none, normal = mesh_data::none;
+                            if (ok && p < end && *p == '/') {
+                                p++;
+                                if (p < end && *p != '/') {
+                                    ok = parse_index(p, end, uvs, total_uvs, "uv", uv, c.reason);
+                                    c.has_uvs = true;
+                                }
+                                if (ok && p < end && *p == '/') {
+                                    p++;
+                                    ok = parse_index(p, end, normals, total_normals, "normal", normal, c.reason);
+                                    c.has_normals = true;
+                                }
+                            }
+                            face_t.push_back(uv);
+                            face_n.push_back(normal);
+                            ok = ok && (p == end || is_space(*p));
+                        }
+                        ok = ok && face_p.size() >= 3;
+
+                        // fan the polygon into triangles
+                        for (size_t k = 1; ok && k + 1 < face_p.size(); k++) {
+                            for (size_t corner : { size_t(0), k, k + 1 }) {
+                                c.position_indices.push_back(face_p[corner]);
+                                c.uv_indices.push_back(face_t[corner]);
+                                c.normal_indices.push_back(face_n[corner]);
+                            }
+                        }
+                        break;
+                    }
+                    default:
+                        break;
+                }
+
+                if (!ok) {
+                    c.error = line;
+                    return false;
+                }
+                line = end + 1;
+            }
+            return true;
+        }
+    }
+
+    // loads the triangles of a wavefront obj: v, vt, vn and f lines, polygons are fanned into triangles.
+    // groups, materials and everything else are skipped. the file is memory mapped and cut into chunks at line
+    // breaks; a first parallel pass counts the vertex lines of every chunk, so the second one knows where in
+    // the shared arrays each chunk's vertices go and parses all of them in parallel too
+    inline bool load_obj(const std::string& path, mesh_data& mesh, int thread_count = 0) {
+        using namespace obj_detail;
+
+        // an empty file is a mesh without triangles, like one of only comments, and has nothing to map
+        std::error_code ec;
+        if (std::filesystem::file_size(path, ec) == 0 && !ec) {
+            mesh = mesh_data();
+            return true;
+        }
+
+        mapped_file file;
+        if (!file.open(path)) {
+            std::cerr << "ERROR: could not open '" << path << "'.\n";
+            return false;
+        }
+        const char* data = file.data();
+        const char* data_end = data + file.size();
+
+        thread_pool pool(thread_count);
+        size_t chunk_count = std::max<size_t>(1, std::min<size_t>(file.size() >> 20, 16 * static_cast<size_t>(pool.size())));
+        std::vector<chunk> chunks(chunk_count);
+        for (size_t i = 0; i < chunk_count; i++) {
+            const char* begin = data + file.size() * i / chunk_count;
+            if (i > 0) begin = std::min(line_end(begin, data_end) + 1, data_end);
+            chunks[i].begin = begin;
+            if (i > 0) chunks[i - 1].end = begin;
+        }
+        chunks.back().end = data_end;
+
+        pool.parallel_for(static_cast<int>(chunk_count), [&](int i, int) {
+            chunk& c = chunks[i];
+            for (const char* line = c.begin; line < c.end;) {
+                const char* end = line_end(line, c.end);
+                const char* p = line;
+                switch (classify(p, end)) {
+                    case line_kind::position: c.positions++; break;
+                    case line_kind::uv: c.uvs++; break;
+                    case line_kind::normal: c.normals++; break;
+                    default: break;
+                }
+                line = end + 1;
+            }
+        });
+
+        size_t positions = 0, uvs = 0, normals = 0;
+        for (auto& c : chunks) {
+            c.position_base = positions;
+            c.uv_base = uvs;
+            c.normal_base = normals;
+            positions += c.positions;
+            uvs += c.uvs;
+            normals += c.normals;
+        }
+        // none marks a corner without a uv or normal, so no index of any kind may reach it
+        if (positions >= mesh_data::none || uvs >= mesh_data::none || normals >= mesh_data::none) {
+            std::cerr << "ERROR: '" << path << "' has too many vertices, uvs or normals.\n";
+            return false;
+        }
+
+        mesh_data result;
+        result.positions.resize(3 * positions);
+        result.uvs.resize(2 * uvs);
+        result.normals.resize(3 * normals);
+
+        pool.parallel_for(static_cast<int>(chunk_count), [&](int i, int) {
+            parse_chunk(chunks[i], result, positions, uvs, normals);
+        });
+
+        for (const auto& c : chunks) {
+            if (c.error) {
+                size_t line_number = 1 + std::count(data, c.error, '\n');
+                std::cerr << "ERROR: '" << path << "' line " << line_number << ": ";
+                if (c.reason)
+                    std::cerr << c.reason << " index out of range in '";
+                else
+                    std::cerr << "could not parse '";
+                std::cerr << std::string(c.error, line_end(c.error, data_end)) << "'.\n";
+                return false;
+            }
+        }
+
+        bool has_uvs = false, has_normals = false;
+        size_t index_count = 0;
+        for (const auto& c : chunks) {
+            has_uvs = has_uvs || c.has_uvs;
+            has_normals = has_normals || c.has_normals;
+            index_count += c.position_indices.size();
+        }
+
+        result.position_indices.resize(index_count);
+        if (has_uvs) result.uv_indices.resize(index_count);
+        if (has_normals) result.normal_indices.resize(index_count);
+        std::vector<size_t> offsets(chunk_count, 0);
+        for (size_t i = 1; i < chunk_count; i++)
+            offsets[i] = offsets[i - 1] + chunks[i - 1].position_indices.size();
+
+        pool.parallel_for(static_cast<int>(chunk_count), [&](int i, int) {
+            chunk& c = chunks[i];
+            std::copy(c.position_indices.begin(), c.position_indices.end(), result.position_indices.begin() + offsets[i]);
+            if (has_uvs) std::copy(c.uv_indices.begin(), c.uv_indices.end(), result.uv_indices.begin() + offsets[i]);
+            if (has_normals) std::copy(c.normal_indices.begin(), c.normal_indices.end(), result.normal_indices.begin() + offsets[i]);
+            c = chunk();
+        });
+
+        mesh = std::move(result);
+        return true;
+    }
+}
@@ -4,10 +4,16 @@
 
 namespace My 
 {
+    class geometry_store;
+    class light_list;
+
     class quad : public hittable 
     {
+        friend class geometry_store;
+        friend class light_list;
+
     public:
-        quad(const point3& Q, const vec3& u, const vec3& v, std::shared_ptr<material> mat)
+        quad(const point3& Q, const vec3& u, const vec3& v, material_id mat)
             : Q(Q), u(u), v(v), mat(mat)
         {
             auto n = cross(u, v);
@@ -26,7 +32,8 @@ namespace My
 
         aabb bounding_box() const override { return bbox; }
 
-        virtual bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+        virtual bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+            RT_COUNT(primitive_tests);
             auto denom = dot(normal, r.direction());
             
             // ray is parallel to the plane
@@ -43,11 +50,34 @@ namespace My
 
             if (!is_interior(alpha, beta, rec)) return false;
 
+            // the uv is already written by is_interior
             rec.t = t;
-            rec.p = intersection;
+            rec.surface = this;
+
+            RT_COUNT(primitive_hits);
+            return true;
+        }
+
+        void set_surface(const ray& r, hit_record& rec) const override {
+            rec.p = r.at(rec.t);
             rec.mat = mat;
-            rec.set_face_normal(r, normal); 
+            rec.set_face_normal(r, normal);
+            rec.dpdu = u;
+            rec.dpdv = v;
+        }
+
+        bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+            RT_COUNT(primitive_tests);
+            double t;
+            return RT_COUNT_HIT(crossing(r, t) && ray_t.contains(t));
+        }
 
+        // a plane meets the line once, so it enters and leaves at the same t
+        bool crossings(const ray& r, double& enter, double& exit, sampler& s) const override {
+            RT_COUNT(primitive_tests);
+            if (!crossing(r, enter)) return false;
+            exit = enter;
+            RT_COUNT(primitive_hits);
             return true;
         }
 
@@ -63,16 +93,31 @@ namespace My
         
 
     private:
+        // where the line of r meets the quad, at any t
+        bool crossing(const ray& r, double& t) const {
+            auto denom = dot(normal, r.direction());
+            if (std::fabs(denom) < 1e-8) return false;
+
+            t = (D - dot(normal, r.origin())) / denom;
+            vec3 planar_hitpt_vector = r.at(t) - Q;
+            auto alpha = dot(w, cross(planar_hitpt_vector, v));
+            auto beta = dot(u, cross(planar_hitpt_vector, w));
+
+            // is_interior also writes the uv, which nobody reads here
+            hit_record scratch;
+            return is_interior(alpha, beta, scratch);
+        }
+
         point3 Q;
         vec3 u, v;
         vec3 w;
-        std::shared_ptr<material> mat;
+        material_id mat;
         aabb bbox;
         vec3 normal;
         double D;
     };
 
-    inline std::shared_ptr<hittable_list> box(const point3& a, const point3& b, std::shared_ptr<material> mat) {
+    inline std::shared_ptr<hittable_list> box(const point3& a, const point3& b, material_id mat) {
         auto sides = std::make_shared<hittable_list>();
 
         auto min = point3(std::fmin(a.x(), b.x()), std::fmin(a.y(), b.y()), std::fmin(a.z(), b.z()));
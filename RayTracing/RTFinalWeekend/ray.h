@@ -1,27 +1,81 @@
-#pragma once
-
-#include "vec3.h"
-
-namespace My {
-    class ray {
-        public:
-            ray() {}
-
-            ray(const point3& origin, const vec3& direction, double time) : orig(origin), dir(direction), tm(time) {}
-            ray(const point3& origin, const vec3& direction) : ray(origin, direction, 0) {}
-
-            const point3& origin() const { return orig; }
-            const vec3& direction() const { return dir; }
-            
-            double time() const { return tm; }
-
-            point3 at(double t) const {
-                return orig + t*dir;
-            }
-
-        private:
-            point3 orig;
-            vec3 dir;
-            double tm;
-    };
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "vec3.h"
+
+namespace My {
+    template <typename T>
+    class basic_ray {
+        public:
+            basic_ray() {}
+
+            basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction, T time) : orig(origin), dir(direction), tm(time) {}
+            basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction) : basic_ray(origin, direction, 0) {}
+
+            const basic_vec3<T>& origin() const { return orig; }
+            const basic_vec3<T>& direction() const { return dir; }
+            
+            T time() const { return tm; }
+
+            basic_vec3<T> at(T t) const {
+                return orig + t*dir;
+            }
+
+        private:
+            basic_vec3<T> orig;
+            basic_vec3<T> dir;
+            T tm;
+    };
+
+    using ray = basic_ray<real>;
+
+    // how far offset_ray_origin moves a coordinate, in its own ulps. float takes the constants of wachter and
+    // binder, "a fast and robust method for avoiding self-intersection" (ray tracing gems, 2019). double moves
+    // as far, 2^29 times as many of its ulps: meshes and instance matrices are stored in float, so a hit point
+    // is no more accurate than that in either build
+    template <typename T> struct ray_offset;
+    template <> struct ray_offset<float> { using bits = int32_t; static constexpr float ulps = 256; };
+    template <> struct ray_offset<double> { using bits = int64_t; static constexpr double ulps = 256.0 * (1 << 29); };
+
+    // p moved off its surface along n, the geometric normal on the side the new ray leaves to, far enough that
+    // the ray can't find the same surface again at t > 0 however p was rounded. the step is a fixed number of
+    // ulps of each coordinate, so it grows with the distance from the origin like the rounding error does;
+    // close to the origin, where ulps get too fine, it is a small constant instead
+    template <typename T>
+    basic_vec3<T> offset_ray_origin(const basic_vec3<T>& p, const basic_vec3<T>& n) {
+        using bits = typename ray_offset<T>::bits;
+        const T near_origin = T(1) / 32;
+        const T near_offset = T(1) / 65536;
+
+        basic_vec3<T> moved;
+        for (int i = 0; i < 3; i++) {
+            if (std::fabs(p[i]) < near_origin) {
+                moved[i] = p[i] + near_offset * n[i];
+                continue;
+            }
+            // stepping the bit pattern moves away from zero for a positive step, whatever the sign of p
+            bits step = static_cast<bits>(ray_offset<T>::ulps * n[i]);
+            bits b;
+            std::memcpy(&b, &p.e[i], sizeof(b));
+            b += p[i] < 0 ? -step : step;
+            std::memcpy(&moved.e[i], &b, sizeof(b));
+        }
+        return moved;
+    }
+
+    // the rays through the neighbouring pixels in x and y, which a camera ray carries to its first hit
+    // so the hit can tell how much of the surface one pixel covers
+    struct ray_differential {
+        point3 rx_origin, ry_origin;
+        vec3 rx_direction, ry_direction;
+    };
+
+    // how far the texture coordinates move from one pixel to the next in x and y. all zero means
+    // unknown, which textures treat as the finest detail they have
+    struct uv_footprint {
+        double dudx = 0, dvdx = 0;
+        double dudy = 0, dvdy = 0;
+    };
 }
\ No newline at end of file
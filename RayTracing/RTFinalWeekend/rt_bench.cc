@@ -0,0 +1,349 @@
+#include "rtweekend.h"
+
+#include "scenes.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace My;
+
+// a scene of the suite and how it is built; the settings below are the same for every scene
+struct bench_scene
+{
+    const char* name;
+    std::function<scene(accel_type)> build;
+};
+
+struct bench_settings
+{
+    int width = 200;
+    int samples_per_pixel = 16;
+    int repeat = 3;
+    int thread_count = 0;
+    accel_type accel = accel_type::sah_bvh;
+};
+
+// rays are the camera rays and bounces of the paths, as in the camera's statistics; shadow rays are not counted.
+// the image is a pure function of the scene and the seed, so rays only change when the renderer does
+struct bench_result
+{
+    std::string name;
+    double build_ms = 0;
+    double render_ms = 0;
+    uint64_t rays = 0;
+    uint64_t pixels = 0;
+
+    double rays_per_second() const { return render_ms > 0 ? rays / (render_ms * 1e-3) : 0.0; }
+    double rays_per_pixel_per_second() const { return pixels > 0 ? rays_per_second() / pixels : 0.0; }
+};
+
+static std::vector<bench_scene> suite() {
+    return {
+        { "bouncing_spheres", [](accel_type a) { return bouncing_spheres(a); } },
+        { "checkered", [](accel_type a) { return checkered_spheres(a); } },
+        { "earth", [](accel_type a) { return earth(a); } },
+        { "perlin", [](accel_type a) { return perlin_noise(a); } },
+        { "quads", [](accel_type a) { return quads(a); } },
+        { "simple_light", [](accel_type a) { return simple_light(a); } },
+        { "cornell", [](accel_type a) { return cornell_box(a); } },
+        { "final_scene", [](accel_type a) { return final_scene(400, 250, 4, a); } },
+    };
+}
+
+static double milliseconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// builds and renders a scene repeat times and keeps the fastest build and render, which are the ones the
+// rest of the machine disturbed least. the camera's progress and statistics are kept off the log meanwhile
+static bench_result run_scene(const bench_scene& entry, const bench_settings& settings) {
+    bench_result result;
+    result.name = entry.name;
+    result.build_ms = result.render_ms = 1e300;
+
+    std::streambuf* log = std::clog.rdbuf(nullptr);
+    for (int r = 0; r < settings.repeat; r++) {
+        // scenes draw their layout from the setup generator; starting it over gives every run the same scene,
+        // whichever scenes ran before
+        random_generator() = pcg32();
+        auto start = std::chrono::steady_clock::now();
+        scene sc = entry.build(settings.accel);
+        result.build_ms = std::min(result.build_ms, milliseconds_since(start));
+
+        sc.cam.image_width = settings.width;
+        sc.cam.samples_per_pixel = settings.samples_per_pixel;
+        sc.cam.thread_count = settings.thread_count;
+        sc.cam.seed = 0;
+
+        start = std::chrono::steady_clock::now();
+        sc.cam.render(sc.world, sc.materials, sc.lights);
+        result.render_ms = std::min(result.render_ms, milliseconds_since(start));
+
+        result.rays = sc.cam.last_stats().rays;
+        result.pixels = static_cast<uint64_t>(sc.cam.image_width) * sc.cam.output_height();
+    }
+    std::clog.clear();
+    std::clog.rdbuf(log);
+    return result;
+}
+
+// what a result file records about how it was run; results only compare when these agree
+struct bench_header
+{
+    std::string precision;
+    std::string accel;
+    int threads = 0;
+    int width = 0;
+    int spp = 0;
+};
+
+static bench_header header_of(const bench_settings& settings) {
+    bench_header h;
+    h.precision = sizeof(real) == sizeof(float) ? "float" : "double";
+    h.accel = accel_name(settings.accel);
+    h.threads = settings.thread_count > 0 ? settings.thread_count : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    h.width = settings.width;
+    h.spp = settings.samples_per_pixel;
+    return h;
+}
+
+static std::string to_json(const bench_settings& settings, const std::vector<bench_result>& results) {
+    bench_header header = header_of(settings);
+
+    std::ostringstream out;
+    out << std::setprecision(6);
+    out << "{\n"
+        << "  \"precision\": \"" << header.precision << "\",\n"
+        << "  \"accel\": \"" << header.accel << "\",\n"
+        << "  \"threads\": " << header.threads << ",\n"
+        << "  \"width\": " << header.width << ",\n"
+        << "  \"spp\": " << header.spp << ",\n"
+        << "  \"repeat\": " << settings.repeat << ",\n"
+        << "  \"scenes\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"build_ms\": " << r.build_ms << ", \"render_ms\": " << r.render_ms
+            << ", \"rays\": " << r.rays << ", \"pixels\": " << r.pixels << ", \"rays_per_second\": " << r.rays_per_second()
+            << ", \"rays_per_pixel_per_second\": " << r.rays_per_pixel_per_second() << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// the number after "key": within text, or false if the key is not there
+static bool json_number(const std::string& text, const char* key, double& value) {
+    std::string quoted = std::string("\"") + key + "\":";
+    size_t at = text.find(quoted);
+    if (at == std::string::npos)
+        return false;
+    char* end;
+    value = std::strtod(text.c_str() + at + quoted.size(), &end);
+    return end != text.c_str() + at + quoted.size();
+}
+
+// the string after "key": within text, or false if the key is not there
+static bool json_string(const std::string& text, const char* key, std::string& value) {
+    std::string quoted = std::string("\"") + key + "\": \"";
+    size_t at = text.find(quoted);
+    if (at == std::string::npos)
+        return false;
+    size_t start = at + quoted.size();
+    size_t end = text.find('"', start);
+    if (end == std::string::npos)
+        return false;
+    value = text.substr(start, end - start);
+    return true;
+}
+
+// reads a file rt_bench wrote: the settings it ran with, then one object per scene, each on its own line
+static bool load_results(const std::string& path, bench_header& header, std::vector<bench_result>& results) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "ERROR: could not open baseline '" << path << "'.\n";
+        return false;
+    }
+
+    std::string line, settings;
+    const std::string name_key = "{\"name\": \"";
+    while (std::getline(in, line)) {
+        size_t at = line.find(name_key);
+        if (at == std::string::npos) {
+            settings += line;
+            continue;
+        }
+        size_t name_end = line.find('"', at + name_key.size());
+        if (name_end == std::string::npos)
+            continue;
+
+        bench_result r;
+        r.name = line.substr(at + name_key.size(), name_end - at - name_key.size());
+        double rays = 0, pixels = 0;
+        if (!json_number(line, "build_ms", r.build_ms) || !json_number(line, "render_ms", r.render_ms) ||
+            !json_number(line, "rays", rays) || !json_number(line, "pixels", pixels)) {
+            std::cerr << "ERROR: baseline scene '" << r.name << "' is missing a value.\n";
+            return false;
+        }
+        r.rays = static_cast<uint64_t>(rays);
+        r.pixels = static_cast<uint64_t>(pixels);
+        results.push_back(r);
+    }
+
+    double threads = 0, width = 0, spp = 0;
+    if (!json_string(settings, "precision", header.precision) || !json_string(settings, "accel", header.accel) ||
+        !json_number(settings, "threads", threads) || !json_number(settings, "width", width) ||
+        !json_number(settings, "spp", spp)) {
+        std::cerr << "ERROR: baseline '" << path << "' does not record the settings it ran with.\n";
+        return false;
+    }
+    header.threads = static_cast<int>(threads);
+    header.width = static_cast<int>(width);
+    header.spp = static_cast<int>(spp);
+    return true;
+}
+
+// rays per second only compare between runs of the same work on the same precision, structure and threads.
+// prints every setting that differs from the baseline and returns whether none did
+static bool same_settings(const bench_header& baseline, const bench_header& current) {
+    bool same = true;
+    auto check = [&](const char* name, const std::string& base, const std::string& now) {
+        if (base == now)
+            return;
+        std::cerr << "ERROR: the baseline ran with " << name << " " << base << ", this run with " << now << ".\n";
+        same = false;
+    };
+    check("precision", baseline.precision, current.precision);
+    check("accel", baseline.accel, current.accel);
+    check("threads", std::to_string(baseline.threads), std::to_string(current.threads));
+    check("width", std::to_string(baseline.width), std::to_string(current.width));
+    check("spp", std::to_string(baseline.spp), std::to_string(current.spp));
+    return same;
+}
+
+// prints how every scene moved against the baseline and returns how many regressed. rays per second
+// regress when they drop by more than tolerance; build times also need to grow by a millisecond or more,
+// since the small scenes build in well under one and their times are mostly noise
+static int compare(const std::vector<bench_result>& baseline, const std::vector<bench_result>& results, double tolerance) {
+    int regressions = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& r : results) {
+        const bench_result* base = nullptr;
+        for (const auto& b : baseline)
+            if (b.name == r.name)
+                base = &b;
+        if (!base) {
+            std::cout << std::left << std::setw(18) << r.name << " not in the baseline\n";
+            continue;
+        }
+
+        double throughput = base->rays_per_second() > 0 ? r.rays_per_second() / base->rays_per_second() - 1 : 0.0;
+        double build = base->build_ms > 0 ? r.build_ms / base->build_ms - 1 : 0.0;
+        bool slower = throughput < -tolerance;
+        bool slower_build = build > tolerance && r.build_ms - base->build_ms >= 1.0;
+        regressions += slower + slower_build;
+
+        std::cout << std::left << std::setw(18) << r.name << std::right
+                  << " rays/s " << std::showpos << std::setw(6) << 100 * throughput << "%" << std::noshowpos
+                  << (slower ? " REGRESSION" : "           ")
+                  << "  build " << std::showpos << std::setw(6) << 100 * build << "%" << std::noshowpos
+                  << (slower_build ? " REGRESSION" : "");
+        if (r.rays != base->rays || r.pixels != base->pixels)
+            std::cout << "  (different work: " << r.rays << " rays over " << r.pixels << " pixels, baseline "
+                      << base->rays << " over " << base->pixels << ")";
+        std::cout << "\n";
+    }
+    return regressions;
+}
+
+static void print_usage() {
+    std::cerr << "usage: rt_bench [--output FILE] [--compare BASELINE] [--tolerance PERCENT] [--repeat N] [--threads N]\n"
+              << "                [--accel bvh_node|linear_bvh|sah_bvh|bvh4|soa_bvh|motion_bvh] [--scene NAME]\n"
+              << "renders a fixed suite of scenes at " << bench_settings().width << " pixels wide and "
+              << bench_settings().samples_per_pixel << " spp, keeping the fastest of --repeat runs (default "
+              << bench_settings().repeat << ").\n"
+              << "the results go to stdout as json unless --output is given. --compare reads a saved result and\n"
+              << "flags scenes whose rays per second dropped or whose build time grew by more than --tolerance\n"
+              << "percent (default 5); it exits with 2 if any did, and refuses a baseline that ran with another\n"
+              << "precision, accel, thread count, width or spp\n";
+}
+
+int main(int argc, char* argv[]) {
+    bench_settings settings;
+    std::string output, baseline_path, only;
+    double tolerance = 5;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--output") == 0 && has_value) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && has_value) {
+            baseline_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            tolerance = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && has_value) {
+            settings.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            settings.thread_count = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--accel") == 0 && has_value) {
+            if (!parse_accel(argv[++i], settings.accel)) {
+                print_usage();
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--scene") == 0 && has_value) {
+            only = argv[++i];
+        } else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::vector<bench_result> baseline;
+    if (!baseline_path.empty()) {
+        bench_header baseline_header;
+        if (!load_results(baseline_path, baseline_header, baseline))
+            return 1;
+        if (!same_settings(baseline_header, header_of(settings))) {
+            std::cerr << "ERROR: refusing to compare against '" << baseline_path << "'; rerun with the settings it recorded.\n";
+            return 1;
+        }
+    }
+
+    std::vector<bench_result> results;
+    for (const auto& entry : suite()) {
+        if (!only.empty() && only != entry.name)
+            continue;
+        results.push_back(run_scene(entry, settings));
+        const auto& r = results.back();
+        std::cerr << std::fixed << std::setprecision(1) << std::left << std::setw(18) << r.name << std::right
+                  << " build " << std::setw(8) << r.build_ms << " ms, render " << std::setw(8) << r.render_ms << " ms, "
+                  << std::setprecision(3) << r.rays_per_second() * 1e-6 << " Mrays/s" << std::endl;
+    }
+    if (results.empty()) {
+        std::cerr << "ERROR: no scene named '" << only << "' in the suite.\n";
+        return 1;
+    }
+
+    std::string json = to_json(settings, results);
+    if (output.empty() && baseline_path.empty()) {
+        std::cout << json;
+    } else if (!output.empty()) {
+        std::ofstream out(output);
+        if (!(out << json)) {
+            std::cerr << "ERROR: could not write '" << output << "'.\n";
+            return 1;
+        }
+    }
+
+    if (!baseline_path.empty())
+        return compare(baseline, results, tolerance / 100) > 0 ? 2 : 0;
+    return 0;
+}
@@ -1,98 +1,187 @@
-#pragma once
-
-#define STB_IMAGE_IMPLEMENTATION
-#define STB_FAILURE_USERMSG
-#include "external/stb_image.h"
-
-#include <cstdlib>
-#include <iostream>
-
-namespace My
-{
-    class rtw_image
-    {
-    public:
-        rtw_image() {}
-
-        rtw_image(const char* image_filename) {
-            auto filename = std::string(image_filename);
-            char* imagedir = nullptr;
-            size_t len;
-            _dupenv_s(&imagedir, &len, "RTW_IMAGES");
-
-            if (imagedir != nullptr) {
-                std::cerr << "RTW_IMAGES: " << imagedir << std::endl;
-                if (load(std::string(imagedir) + "/" + filename)) {
-                    free(imagedir);
-                    return;
-                }
-                free(imagedir);
-            }
-
-            if (load(filename)) return;
-            if (load(std::string("images/") + filename)) return;
-
-            std::cerr << "Failed to load image file: " << image_filename << std::endl;
-        }
-
-        ~rtw_image() {
-            delete[] bdata;
-            STBI_FREE(fdata);
-        }
-
-        bool load(const std::string& filename) {
-            auto n = bytes_per_pixel;
-            fdata = stbi_loadf(filename.c_str(), &image_width, &image_height, &n, bytes_per_pixel);
-            if (fdata == nullptr) return false;
-
-            bytes_per_scanline = image_width * bytes_per_pixel;
-            convert_to_bytes();
-            return true;
-        }
-
-        int width() const { return image_width; }
-        int height() const { return image_height; }
-        
-        const unsigned char* pixel_data(int x, int y) const {
-            static unsigned char magenta[] = { 255, 0, 255 };
-            if (bdata == nullptr) return magenta;
-
-            x = clamp(x, 0, image_width - 1);
-            y = clamp(y, 0, image_height - 1);
-
-            return bdata + y * bytes_per_scanline + x * bytes_per_pixel;
-        }
-
-    private:
-        const int bytes_per_pixel = 3;
-        float *fdata = nullptr;
-        unsigned char *bdata = nullptr;
-        int image_width = 0;
-        int image_height = 0;
-        int bytes_per_scanline = 0;
-
-        static int clamp(int x, int low, int high) {
-            if (x < low) return low;
-            if (x > high) return high;
-            return x;
-        }
-
-        static unsigned char float_to_byte(float value) {
-            if (value <= 0.0) return 0; 
-            if (1.0 <= value) return 255;
-            return static_cast<unsigned char>(value * 256.0);
-        }
-
-        void convert_to_bytes() {
-            // floating point pixel data to bytes
-            int total_bytes = image_width * image_height * bytes_per_pixel;
-            bdata = new unsigned char[total_bytes];
-
-            auto *bptr = bdata;
-            auto *fptr = fdata;
-            for (auto i = 0; i < total_bytes; i++, fptr++, bptr++) {
-                *bptr = float_to_byte(*fptr);
-            }
-        }
-    };
-}
\ No newline at end of file
+#pragma once
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_FAILURE_USERMSG
+#include "external/stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace My
+{
+    // an 8-bit rgb image and its mip chain in one byte buffer. level 0 is the image as loaded, every further
+    // level halves both sides (rounded down, at least 1) until 1x1. the bytes are gamma 2.2 encoded, the same
+    // curve stbi_loadf decodes with, and to_linear turns them back into linear values. the chain adds a third
+    // to the image, which is still about a quarter of the float and byte copies this used to keep
+    class rtw_image
+    {
+    public:
+        struct level
+        {
+            int width;
+            int height;
+            size_t offset;      // of the first byte in pixels
+        };
+
+        rtw_image() {}
+
+        rtw_image(const char* image_filename) {
+            std::string path = find(image_filename);
+            if (path.empty() || !load(path))
+                std::cerr << "Failed to load image file: " << image_filename << std::endl;
+        }
+
+        // the first of RTW_IMAGES/filename, filename and images/filename that exists, empty if none does
+        static std::string find(const char* image_filename) {
+            auto filename = std::string(image_filename);
+            std::vector<std::string> candidates;
+            char* imagedir = nullptr;
+            size_t len;
+            _dupenv_s(&imagedir, &len, "RTW_IMAGES");
+
+            if (imagedir != nullptr) {
+                std::cerr << "RTW_IMAGES: " << imagedir << std::endl;
+                candidates.push_back(std::string(imagedir) + "/" + filename);
+                free(imagedir);
+            }
+            candidates.push_back(filename);
+            candidates.push_back(std::string("images/") + filename);
+
+            for (const auto& path : candidates) {
+                if (std::FILE* file = std::fopen(path.c_str(), "rb")) {
+                    std::fclose(file);
+                    return path;
+                }
+            }
+            return std::string();
+        }
+
+        // large, so it is moved (into a texture table) but not copied
+        rtw_image(const rtw_image&) = delete;
+        rtw_image& operator=(const rtw_image&) = delete;
+        rtw_image(rtw_image&&) noexcept = default;
+        rtw_image& operator=(rtw_image&&) noexcept = default;
+
+        // hdr files come through stbi's tone curve, clamped to [0, 1]
+        bool load(const std::string& filename) {
+            int width, height, n;
+            unsigned char* data = stbi_load(filename.c_str(), &width, &height, &n, bytes_per_pixel);
+            if (data == nullptr) return false;
+
+            build_levels(data, width, height);
+            stbi_image_free(data);
+            return true;
+        }
+
+        int width() const { return levels.empty() ? 0 : levels[0].width; }
+        int height() const { return levels.empty() ? 0 : levels[0].height; }
+        int level_count() const { return static_cast<int>(levels.size()); }
+        const level& level_info(int l) const { return levels[l]; }
+
+        // the texel at x, y of a mip level, clamped to its edges; magenta if nothing was loaded
+        const unsigned char* pixel_data(int x, int y, int l = 0) const {
+            static unsigned char magenta[] = { 255, 0, 255 };
+            if (levels.empty()) return magenta;
+
+            const level& lv = levels[l];
+            x = clamp(x, 0, lv.width - 1);
+            y = clamp(y, 0, lv.height - 1);
+
+            return pixels.data() + lv.offset + (static_cast<size_t>(y) * lv.width + x) * bytes_per_pixel;
+        }
+
+        static float to_linear(unsigned char value) { return linear_table().values[value]; }
+
+        size_t memory_bytes() const { return pixels.size() + levels.size() * sizeof(level); }
+
+    private:
+        static constexpr int bytes_per_pixel = 3;
+        static constexpr double gamma = 2.2;
+        std::vector<unsigned char> pixels;
+        std::vector<level> levels;
+
+        struct lookup
+        {
+            float values[256];
+
+            lookup() {
+                for (int i = 0; i < 256; i++)
+                    values[i] = static_cast<float>(std::pow(i / 255.0, gamma));
+            }
+        };
+
+        static const lookup& linear_table() {
+            static const lookup table;
+            return table;
+        }
+
+        static int clamp(int x, int low, int high) {
+            if (x < low) return low;
+            if (x > high) return high;
+            return x;
+        }
+
+        static unsigned char to_byte(float value) {
+            if (value <= 0) return 0;
+            if (value >= 1) return 255;
+            return static_cast<unsigned char>(255 * std::pow(value, 1 / gamma) + 0.5);
+        }
+
+        // each texel of a level averages a 2x2 block of the one above in linear space; with an odd side the
+        // last texel takes the leftover row or column as well. the averages are carried on in float, so the
+        // byte rounding of one level does not add up down the chain
+        void build_levels(const unsigned char* data, int width, int height) {
+            levels.clear();
+            size_t total = 0;
+            for (int w = width, h = height; ; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+                levels.push_back({ w, h, total });
+                total += static_cast<size_t>(w) * h * bytes_per_pixel;
+                if (w == 1 && h == 1) break;
+            }
+
+            pixels.resize(total);
+            size_t base_bytes = static_cast<size_t>(width) * height * bytes_per_pixel;
+            std::memcpy(pixels.data(), data, base_bytes);
+
+            std::vector<float> above(base_bytes);
+            for (size_t i = 0; i < base_bytes; i++)
+                above[i] = to_linear(data[i]);
+
+            std::vector<float> current;
+            for (size_t l = 1; l < levels.size(); l++) {
+                const level& src = levels[l - 1];
+                const level& dst = levels[l];
+                current.assign(static_cast<size_t>(dst.width) * dst.height * bytes_per_pixel, 0.0f);
+                unsigned char* out = pixels.data() + dst.offset;
+
+                for (int y = 0; y < dst.height; y++) {
+                    int y0 = 2 * y, y1 = (y == dst.height - 1) ? src.height : std::min(2 * y + 2, src.height);
+                    for (int x = 0; x < dst.width; x++) {
+                        int x0 = 2 * x, x1 = (x == dst.width - 1) ? src.width : std::min(2 * x + 2, src.width);
+                        float sum[bytes_per_pixel] = {};
+                        for (int sy = y0; sy < y1; sy++)
+                            for (int sx = x0; sx < x1; sx++)
+                                for (int c = 0; c < bytes_per_pixel; c++)
+                                    sum[c] += above[(static_cast<size_t>(sy) * src.width + sx) * bytes_per_pixel + c];
+
+                        float scale = 1.0f / ((y1 - y0) * (x1 - x0));
+                        size_t index = (static_cast<size_t>(y) * dst.width + x) * bytes_per_pixel;
+                        for (int c = 0; c < bytes_per_pixel; c++) {
+                            current[index + c] = sum[c] * scale;
+                            out[index + c] = to_byte(current[index + c]);
+                        }
+                    }
+                }
+                above.swap(current);
+            }
+        }
+    };
+}
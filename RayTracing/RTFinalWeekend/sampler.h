@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+namespace My
+{
+    // splitmix64 finalizer, a cheap full-avalanche 64-bit mix
+    inline uint64_t mix_bits(uint64_t v) {
+        v ^= v >> 30;
+        v *= 0xbf58476d1ce4e5b9ULL;
+        v ^= v >> 27;
+        v *= 0x94d049bb133111ebULL;
+        v ^= v >> 31;
+        return v;
+    }
+
+    // top 53 bits to a double in [0, 1)
+    inline double bits_to_unit(uint64_t bits) {
+        return (bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // PCG-XSH-RR 64/32, a small sequential generator for scene setup (random scenes, perlin tables)
+    class pcg32
+    {
+    public:
+        explicit pcg32(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+            state = 0;
+            inc = (stream << 1) | 1;
+            next_uint();
+            state += seed;
+            next_uint();
+        }
+
+        uint32_t next_uint() {
+            uint64_t old = state;
+            state = old * 6364136223846793005ULL + inc;
+            auto xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+            auto rot = static_cast<uint32_t>(old >> 59);
+            return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+        }
+
+        // uniform in [0, 1)
+        double next_double() {
+            uint64_t hi = next_uint();
+            uint64_t lo = next_uint();
+            return bits_to_unit((hi << 32) | lo);
+        }
+
+        double next_double(double min, double max) {
+            return min + (max - min) * next_double();
+        }
+
+    private:
+        uint64_t state;
+        uint64_t inc;
+    };
+
+    // independent draws every dimension at random. stratified jitters every dimension over the samples of a
+    // pixel (a randomly permuted stratum each), the camera's pixel offset on a square grid. halton is the
+    // radical inverse in a prime base per dimension with random digit permutations. sobol is the (0, 2)-sequence
+    // owen scrambled per dimension, with the sample order shuffled for every pair of dimensions (burley 2020),
+    // so it has no dimension limit
+    enum class sampler_type { independent, stratified, halton, sobol };
+
+    inline const char* sampler_name(sampler_type type) {
+        switch (type) {
+            case sampler_type::independent: return "independent";
+            case sampler_type::stratified: return "stratified";
+            case sampler_type::halton: return "halton";
+            case sampler_type::sobol: return "sobol";
+        }
+        return "?";
+    }
+
+    inline bool parse_sampler(const char* name, sampler_type& type) {
+        for (auto candidate : { sampler_type::independent, sampler_type::stratified, sampler_type::halton, sampler_type::sobol }) {
+            if (std::strcmp(name, sampler_name(candidate)) == 0) {
+                type = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint32_t reverse_bits(uint32_t v) {
+        v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+        v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+        v = ((v >> 4) & 0x0f0f0f0fu) | ((v & 0x0f0f0f0fu) << 4);
+        v = ((v >> 8) & 0x00ff00ffu) | ((v & 0x00ff00ffu) << 8);
+        return (v >> 16) | (v << 16);
+    }
+
+    // laine and karras' hash permutation with burley's constants: every bit is flipped depending on the bits
+    // below it, an owen scramble of the bit reversed value
+    inline uint32_t laine_karras_permutation(uint32_t v, uint32_t seed) {
+        v += seed;
+        v ^= v * 0x6c50b47cu;
+        v ^= v * 0xb82f1e52u;
+        v ^= v * 0xc7afe638u;
+        v ^= v * 0x8d22f6e6u;
+        return v;
+    }
+
+    inline uint32_t owen_scramble(uint32_t v, uint32_t seed) {
+        return reverse_bits(laine_karras_permutation(reverse_bits(v), seed));
+    }
+
+    // the first two sobol dimensions as bit reversed 0.32 fixed point, so they can go through
+    // laine_karras_permutation directly: van der corput is the index itself, the second dimension (the pascal
+    // matrix) xors a direction number per set index bit, looked up a byte of the index at a time
+    inline uint32_t sobol_reversed(uint32_t index, uint32_t dimension) {
+        if (dimension == 0)
+            return index;
+
+        struct byte_tables
+        {
+            uint32_t values[4][256];
+
+            byte_tables() {
+                uint32_t directions[32];
+                uint32_t v = 1u << 31;
+                for (int bit = 0; bit < 32; bit++, v ^= v >> 1)
+                    directions[bit] = reverse_bits(v);
+                for (int byte = 0; byte < 4; byte++) {
+                    for (uint32_t i = 0; i < 256; i++) {
+                        uint32_t x = 0;
+                        for (int bit = 0; bit < 8; bit++)
+                            if (i & (1u << bit))
+                                x ^= directions[byte * 8 + bit];
+                        values[byte][i] = x;
+                    }
+                }
+            }
+        };
+        static const byte_tables tables;
+
+        return tables.values[0][index & 0xff] ^ tables.values[1][(index >> 8) & 0xff] ^
+               tables.values[2][(index >> 16) & 0xff] ^ tables.values[3][index >> 24];
+    }
+
+    // kensler's hash permutation of [0, n), a different one for every seed
+    inline uint32_t permute_index(uint32_t i, uint32_t n, uint32_t seed) {
+        uint32_t w = n - 1;
+        w |= w >> 1;
+        w |= w >> 2;
+        w |= w >> 4;
+        w |= w >> 8;
+        w |= w >> 16;
+        do {
+            i ^= seed;
+            i *= 0xe170893du;
+            i ^= seed >> 16;
+            i ^= (i & w) >> 4;
+            i ^= seed >> 8;
+            i *= 0x0929eb3fu;
+            i ^= seed >> 23;
+            i ^= (i & w) >> 1;
+            i *= 1 | seed >> 27;
+            i *= 0x6935fa69u;
+            i ^= (i & w) >> 11;
+            i *= 0x74dcb303u;
+            i ^= (i & w) >> 2;
+            i *= 0x9e501cc3u;
+            i ^= (i & w) >> 2;
+            i *= 0xc860a3dfu;
+            i &= w;
+            i ^= i >> 5;
+        } while (i >= n);
+        return (i + seed) % n;
+    }
+
+    // per-sample numbers behind one interface for every sampler_type. a value is a pure function of
+    // (seed, pixel, sample, bounce, dimension), so there is no state shared between threads and
+    // any single pixel sample can be replayed on its own.
+    // the camera draws from slot 0, bounce k from slot k + 1; every slot counts its own dimensions,
+    // so a bounce sees the same numbers however many the previous bounces consumed.
+    // set_size is the sample count the stratified sampler spreads each dimension over: samples
+    // [k * set_size, (k + 1) * set_size) of a pixel form one stratified set
+    class sampler
+    {
+    public:
+        explicit sampler(uint64_t seed = 0, sampler_type type = sampler_type::independent, uint32_t set_size = 1)
+            : seed(seed), type(type), set_size(set_size > 0 ? set_size : 1) {}
+
+        sampler_type kind() const { return type; }
+
+        void start_pixel_sample(uint32_t pixel_index, uint32_t sample_index) {
+            pixel_key = mix_bits(seed + mix_bits((static_cast<uint64_t>(pixel_index) << 32) | sample_index));
+            pixel_hash = mix_bits(seed ^ mix_bits(static_cast<uint64_t>(pixel_index) + 0x632be59bd9b4e019ULL));
+            index = sample_index;
+            slot = 0;
+            dimension = 0;
+        }
+
+        void start_bounce(int bounce) {
+            slot = static_cast<uint32_t>(bounce) + 1;
+            dimension = 0;
+        }
+
+        // uniform in [0, 1)
+        double get_1d() {
+            uint32_t d = dimension++;
+            switch (type) {
+                case sampler_type::stratified: return stratified_1d(d);
+                case sampler_type::halton: return halton_1d(d);
+                case sampler_type::sobol: return sobol_1d(d);
+                default: return independent_1d(d);
+            }
+        }
+
+        double get_1d(double min, double max) {
+            return min + (max - min) * get_1d();
+        }
+
+    private:
+        static constexpr uint32_t halton_slot_dimensions = 8;   // dimensions per slot with a halton base
+        static constexpr uint32_t halton_bases = 64;            // past these, halton falls back to independent
+
+        uint64_t seed;
+        sampler_type type;
+        uint32_t set_size;
+        uint64_t pixel_key = 0;     // pixel and sample
+        uint64_t pixel_hash = 0;    // pixel only, the scrambling of the sequences
+        uint32_t index = 0;
+        uint32_t slot = 0;
+        uint32_t dimension = 0;
+
+        uint64_t dimension_hash(uint32_t d) const {
+            return mix_bits(pixel_hash + ((static_cast<uint64_t>(slot) << 32) | d) * 0x9e3779b97f4a7c15ULL);
+        }
+
+        double independent_1d(uint32_t d) const {
+            uint64_t counter = (static_cast<uint64_t>(slot) << 32) | d;
+            return bits_to_unit(mix_bits(pixel_key + counter * 0x9e3779b97f4a7c15ULL));
+        }
+
+        double stratified_1d(uint32_t d) const {
+            uint32_t set = index / set_size;
+            uint64_t h = mix_bits(dimension_hash(d) + set);
+            uint32_t stratum = permute_index(index % set_size, set_size, static_cast<uint32_t>(h));
+            return (stratum + independent_1d(d)) / set_size;
+        }
+
+        double halton_1d(uint32_t d) const {
+            static const uint32_t primes[halton_bases] = {
+                2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+                59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+                137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+                227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311 };
+
+            uint32_t base_index = slot * halton_slot_dimensions + d;
+            if (d >= halton_slot_dimensions || base_index >= halton_bases)
+                return independent_1d(d);
+
+            // every digit goes through its own random permutation of [0, base), digit -> (m * digit + c) mod base
+            // with m != 0, as many digits as the largest index has. the digits below those are permuted zeros for
+            // every index, so they are drawn as one uniform tail shared by all samples
+            uint32_t base = primes[base_index];
+            uint64_t h = dimension_hash(d);
+            double tail = bits_to_unit(mix_bits(h ^ 0xd1b54a32d192ed03ULL));
+            double result = 0;
+            if (base == 2) {
+                // a permutation of a bit is a flip
+                result = ((reverse_bits(index) ^ static_cast<uint32_t>(h)) + tail) * (1.0 / 4294967296.0);
+            } else {
+                double inv_base = 1.0 / base;
+                double weight = inv_base;
+                uint64_t r = h;
+                for (uint32_t a = index, digits_left = UINT32_MAX; digits_left; a /= base, digits_left /= base) {
+                    r = r * 6364136223846793005ULL + 1442695040888963407ULL;    // the high bits of an lcg step are plenty here
+                    auto m = 1 + static_cast<uint32_t>((((r >> 16) & 0xffff) * (base - 1)) >> 16);
+                    auto c = static_cast<uint32_t>(((r >> 32) * base) >> 32);
+                    result += ((m * (a % base) + c) % base) * weight;
+                    weight *= inv_base;
+                }
+                result += weight * base * tail;
+            }
+            return result < 1.0 ? result : 0x1.fffffffffffffp-1;
+        }
+
+        double sobol_1d(uint32_t d) const {
+            uint64_t pair = dimension_hash(d & ~1u);
+            uint32_t shuffled = owen_scramble(index, static_cast<uint32_t>(pair));
+            uint32_t reversed = sobol_reversed(shuffled, d & 1);
+            uint32_t bits = reverse_bits(laine_karras_permutation(reversed, static_cast<uint32_t>(pair >> 32) + (d & 1) * 0x9e3779b9u));
+            // the middle of the 2^-32 wide cell, never 0 or 1
+            return (bits + 0.5) * (1.0 / 4294967296.0);
+        }
+    };
+}
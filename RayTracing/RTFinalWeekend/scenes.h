@@ -0,0 +1,667 @@
+#pragma once
+
+#include "rtweekend.h"
+
+#include "bvh.h"
+#include "camera.h"
+#include "constant_medium.h"
+#include "geometry_store.h"
+#include "heterogeneous_medium.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "instance_bvh.h"
+#include "lights.h"
+#include "linear_bvh.h"
+#include "material.h"
+#include "motion_bvh.h"
+#include "obj_loader.h"
+#include "quad.h"
+#include "sphere.h"
+#include "texture.h"
+#include "triangle_mesh.h"
+#include "wide_bvh.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+// demo scenes from the book series, each returning its world and a configured camera
+namespace My
+{
+    // bvh_node is the book's pointer tree, linear_bvh the flat bvh split at the median, sah_bvh the flat bvh built with
+    // binned sah, bvh4 the sah tree collapsed to four children per node, soa_bvh the sah bvh over a geometry_store and
+    // motion_bvh the sah bvh with node bounds at both ends of the shutter
+    enum class accel_type { bvh_node, linear_bvh, sah_bvh, bvh4, soa_bvh, motion_bvh };
+
+    inline const char* accel_name(accel_type accel) {
+        switch (accel) {
+            case accel_type::bvh_node: return "bvh_node";
+            case accel_type::linear_bvh: return "linear_bvh";
+            case accel_type::sah_bvh: return "sah_bvh";
+            case accel_type::bvh4: return "bvh4";
+            case accel_type::motion_bvh: return "motion_bvh";
+            default: return "soa_bvh";
+        }
+    }
+
+    inline bool parse_accel(const char* name, accel_type& accel) {
+        for (auto candidate : { accel_type::bvh_node, accel_type::linear_bvh, accel_type::sah_bvh, accel_type::bvh4,
+                                accel_type::soa_bvh, accel_type::motion_bvh }) {
+            if (std::strcmp(name, accel_name(candidate)) == 0) {
+                accel = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline shared_ptr<hittable> make_accel(const hittable_list& list, accel_type accel) {
+        if (accel == accel_type::bvh_node)
+            return make_shared<bvh_node>(list);
+
+        bvh_builder builder;
+        builder.split = (accel == accel_type::linear_bvh) ? bvh_split::median : bvh_split::sah;
+        // lists without moving objects gain nothing from interpolated bounds and get the plain sah bvh
+        if (accel == accel_type::motion_bvh && motion_bvh::has_motion(list))
+            return make_shared<motion_bvh>(list, builder);
+        if (accel == accel_type::bvh4)
+            return make_shared<bvh4>(list, builder);
+        if (accel == accel_type::soa_bvh) {
+            auto store = make_shared<geometry_store>();
+            store->add(list);
+            store->build(builder);
+            return store;
+        }
+        return make_shared<linear_bvh>(list, builder);
+    }
+
+    // wrap the top-level objects of a scene in the chosen acceleration structure
+    inline hittable_list accelerate(const hittable_list& list, accel_type accel) {
+        return hittable_list(make_accel(list, accel));
+    }
+
+    // a single instance of object, in place of a translate and rotate_y chain
+    inline shared_ptr<instance_bvh> place(shared_ptr<hittable> object, const affine_transform& object_to_world) {
+        auto placed = make_shared<instance_bvh>();
+        placed->add_instance(placed->add_geometry(std::move(object)), object_to_world);
+        placed->build();
+        return placed;
+    }
+
+    struct scene
+    {
+        hittable_list world;
+        material_table materials;
+        light_list lights;
+        camera cam;
+    };
+
+    // registers the emissive primitives of the plain world, then wraps it in the chosen acceleration structure
+    inline scene make_scene(const hittable_list& world, material_table&& materials, const camera& cam, accel_type accel) {
+        scene sc;
+        sc.lights.collect(world, materials);
+        sc.world = accelerate(world, accel);
+        sc.materials = std::move(materials);
+        sc.cam = cam;
+        return sc;
+    }
+
+    inline scene bouncing_spheres(accel_type accel) {
+        // World
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto checker = textures.add(checker_texture(0.32, textures.add(solid_color(0.2, 0.3, 0.1)),
+                                                          textures.add(solid_color(0.9, 0.9, 0.9))));
+        world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, materials.add(lambertian(checker))));
+
+        for (int a = -11; a < 11; a++) {
+            for (int b = -11; b < 11; b++) {
+                auto choose_mat = random_double();
+                point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+
+                if ((center - point3(4, 0.2, 0)).length() > 0.9) {
+                    material_id sphere_material;
+
+                    if (choose_mat < 0.8) {
+                        // diffuse
+                        auto albedo = color::random() * color::random();
+                        sphere_material = materials.add(lambertian(textures.add(solid_color(albedo))));
+                        auto center2 = center + vec3(0, random_double(0, .5), 0);
+                        world.add(make_shared<sphere>(center, center2, 0.2, sphere_material));
+                    } else if (choose_mat < 0.95) {
+                        // metal
+                        auto albedo = color::random(0.5, 1);
+                        auto fuzz = random_double(0, 0.5);
+                        sphere_material = materials.add(metal(albedo, fuzz));
+                        world.add(make_shared<sphere>(center, 0.2, sphere_material));
+                    } else {
+                        // glass
+                        sphere_material = materials.add(dielectric(1.5));
+                        world.add(make_shared<sphere>(center, 0.2, sphere_material));
+                    }
+                }
+            }
+        }
+
+        auto material1 = materials.add(dielectric(1.5));
+        world.add(make_shared<sphere>(point3(0, 1, 0), 1.0, material1));
+
+        auto material2 = materials.add(lambertian(textures.add(solid_color(0.4, 0.2, 0.1))));
+        world.add(make_shared<sphere>(point3(-4, 1, 0), 1.0, material2));
+
+        auto material3 = materials.add(metal(color(0.7, 0.6, 0.5), 0.0));
+        world.add(make_shared<sphere>(point3(4, 1, 0), 1, material3));
+
+        // Camera
+        camera cam;
+        cam.aspect_ratio = 16.0 / 9.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.70, 0.80, 1.00);
+
+        cam.vfov = 20;
+        cam.lookfrom = point3(13, 2, 3);
+        cam.lookat = point3(0, 0, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0.6;
+        cam.focus_dist = 10.0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    inline scene checkered_spheres(accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto checker = textures.add(checker_texture(0.32, textures.add(solid_color(0.2, 0.3, 0.1)),
+                                                          textures.add(solid_color(0.9, 0.9, 0.9))));
+
+        world.add(make_shared<sphere>(point3(0, -10, 0), 10, materials.add(lambertian(checker))));
+        world.add(make_shared<sphere>(point3(0, 10, 0), 10, materials.add(lambertian(checker))));
+
+        camera cam;
+        cam.aspect_ratio = 16.0 / 9.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.70, 0.80, 1.00);
+
+        cam.vfov = 20;
+        cam.lookfrom = point3(13, 2, 3);
+        cam.lookat = point3(0, 0, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+        
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    inline scene earth(accel_type accel) {
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto earth_texture = textures.add(image_texture("earthmap.jpg", textures.cache()));
+        auto earth_surface = materials.add(lambertian(earth_texture));
+        auto globe = make_shared<sphere>(point3(0, 0, 0), 2, earth_surface);
+
+        camera cam;
+
+        cam.aspect_ratio = 16.0 / 9.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.70, 0.80, 1.00);
+
+        cam.vfov = 20;
+        cam.lookfrom = point3(0, 0, 12);
+        cam.lookat = point3(0, 0, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(hittable_list(globe), std::move(materials), cam, accel);
+    }
+
+    inline scene perlin_noise(accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto pertext = textures.add(noise_texture(4));
+        world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, materials.add(lambertian(pertext))));
+        world.add(make_shared<sphere>(point3(0, 2, 0), 2, materials.add(lambertian(pertext))));
+
+        camera cam;
+
+        cam.aspect_ratio = 16.0 / 9.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.70, 0.80, 1.00);
+
+        cam.vfov = 20;
+        cam.lookfrom = point3(13, 2, 3);
+        cam.lookat = point3(0, 0, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    inline scene quads(accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto left_red = materials.add(lambertian(textures.add(solid_color(1.0, 0.2, 0.2))));
+        auto back_green = materials.add(lambertian(textures.add(solid_color(0.2, 1.0, 0.2))));
+        auto right_blue = materials.add(lambertian(textures.add(solid_color(0.2, 0.2, 1.0))));
+        auto upper_orange = materials.add(lambertian(textures.add(solid_color(1.0, 0.5, 0.0))));
+        auto lower_teal = materials.add(lambertian(textures.add(solid_color(0.2, 0.8, 0.8))));
+
+        world.add(make_shared<quad>(point3(-3, -2, 5), vec3(0, 0, -4), vec3(0, 4, 0), left_red));
+        world.add(make_shared<quad>(point3(-2, -2, 0), vec3(4, 0, 0), vec3(0, 4, 0), back_green));
+        world.add(make_shared<quad>(point3(3, -2, 1), vec3(0, 0, 4), vec3(0, 4, 0), right_blue));
+        world.add(make_shared<quad>(point3(-2, 3, 1), vec3(4, 0, 0), vec3(0, 0, 4), upper_orange));
+        world.add(make_shared<quad>(point3(-2, -3, 5), vec3(4, 0, 0), vec3(0, 0, -4), lower_teal));
+        
+        camera cam;
+
+        cam.aspect_ratio = 1.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.70, 0.80, 1.00);
+
+        cam.vfov = 80;
+        cam.lookfrom = point3(0, 0, 9);
+        cam.lookat = point3(0, 0, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    inline scene simple_light(accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto pertext = textures.add(noise_texture(4));
+        world.add(make_shared<sphere>(point3(0, -1000, 0), 1000, materials.add(lambertian(pertext))));
+        world.add(make_shared<sphere>(point3(0, 2, 0), 2, materials.add(lambertian(pertext))));
+
+        auto difflight = materials.add(diffuse_light(textures.add(solid_color(4, 4, 4))));
+        world.add(make_shared<sphere>(point3(0, 7, 0), 2, difflight));
+        world.add(make_shared<quad>(point3(3, 1, -2), vec3(2, 0, 0), vec3(0, 2, 0), difflight));
+
+        camera cam;
+
+        cam.aspect_ratio = 16.0 / 9.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.0, 0.0, 0.0);
+
+        cam.vfov = 20;
+        cam.lookfrom = point3(26, 3, 6);
+        cam.lookat = point3(0, 2, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    inline scene cornell_box(accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto red = materials.add(lambertian(textures.add(solid_color(.65, 0.05, 0.05))));
+        auto white = materials.add(lambertian(textures.add(solid_color(.73, .73, .73))));
+        auto green = materials.add(lambertian(textures.add(solid_color(0.12, 0.45, 0.15))));
+        auto light = materials.add(diffuse_light(textures.add(solid_color(15, 15, 15))));
+
+        world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 0, 555), vec3(0, 555, 0), green));
+        world.add(make_shared<quad>(point3(0, 0, 555), vec3(0, 0, -555), vec3(0, 555, 0), red));
+        world.add(make_shared<quad>(point3(0, 555, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+        world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 0, -555), white));
+        world.add(make_shared<quad>(point3(555, 0, 555), vec3(-555, 0, 0), vec3(0, 555, 0), white));
+
+        world.add(make_shared<quad>(point3(213, 554, 227), vec3(130, 0, 0), vec3(0, 0, 105), light));
+
+        auto boxes = make_shared<instance_bvh>();
+        auto tall = boxes->add_geometry(box(point3(0, 0, 0), point3(165, 330, 165), white));
+        auto short_box = boxes->add_geometry(box(point3(0, 0, 0), point3(165, 165, 165), white));
+        boxes->add_instance(tall, affine_transform::translation(vec3(265, 0, 295)) * affine_transform::rotation_y(15));
+        boxes->add_instance(short_box, affine_transform::translation(vec3(130, 0, 65)) * affine_transform::rotation_y(-18));
+        boxes->build();
+        world.add(boxes);
+
+        camera cam;
+
+        cam.aspect_ratio = 1.0;
+        cam.image_width = 600;
+        cam.samples_per_pixel = 64;
+        cam.max_depth = 50;
+        cam.background = color(0.0, 0.0, 0.0);
+
+        cam.vfov = 40;
+        cam.lookfrom = point3(278, 278, -800);
+        cam.lookat = point3(278, 278, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    // the cornell box with the triangles of an obj file in place of the boxes, scaled to 330 units
+    // and standing on the floor in the middle. false if the file does not load
+    inline bool obj_scene(const std::string& path, accel_type accel, scene& sc) {
+        mesh_data mesh;
+        auto start = std::chrono::steady_clock::now();
+        if (!load_obj(path, mesh))
+            return false;
+        std::chrono::duration<double, std::milli> load_ms = std::chrono::steady_clock::now() - start;
+
+        aabb bounds = mesh.bounds();
+        double extent = std::fmax(bounds.x.size(), std::fmax(bounds.y.size(), bounds.z.size()));
+        double scale = extent > 0 ? 330 / extent : 1;
+        vec3 offset(278 - scale * 0.5 * (bounds.x.min + bounds.x.max), -scale * bounds.y.min,
+                    278 - scale * 0.5 * (bounds.z.min + bounds.z.max));
+        mesh.transform(scale, offset);
+
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto red = materials.add(lambertian(textures.add(solid_color(.65, 0.05, 0.05))));
+        auto white = materials.add(lambertian(textures.add(solid_color(.73, .73, .73))));
+        auto green = materials.add(lambertian(textures.add(solid_color(0.12, 0.45, 0.15))));
+        auto light = materials.add(diffuse_light(textures.add(solid_color(15, 15, 15))));
+
+        world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 0, 555), vec3(0, 555, 0), green));
+        world.add(make_shared<quad>(point3(0, 0, 555), vec3(0, 0, -555), vec3(0, 555, 0), red));
+        world.add(make_shared<quad>(point3(0, 555, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+        world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 0, -555), white));
+        world.add(make_shared<quad>(point3(555, 0, 555), vec3(-555, 0, 0), vec3(0, 555, 0), white));
+
+        world.add(make_shared<quad>(point3(213, 554, 227), vec3(130, 0, 0), vec3(0, 0, 105), light));
+
+        auto mesh_material = materials.add(lambertian(textures.add(solid_color(.73, .73, .73))));
+        auto object = make_shared<triangle_mesh>(std::move(mesh), mesh_material);
+        const auto& stats = object->build_stats();
+        std::clog << "Mesh: " << object->triangle_count() << " triangles, " << object->vertex_count() << " vertices, loaded in "
+                  << load_ms.count() << " ms, bvh of " << stats.node_count << " nodes built in " << stats.build_ms << " ms, "
+                  << object->memory_bytes() / (1024.0 * 1024.0) << " MiB" << std::endl;
+        world.add(object);
+
+        camera cam;
+
+        cam.aspect_ratio = 1.0;
+        cam.image_width = 600;
+        cam.samples_per_pixel = 64;
+        cam.max_depth = 50;
+        cam.background = color(0.0, 0.0, 0.0);
+
+        cam.vfov = 40;
+        cam.lookfrom = point3(278, 278, -800);
+        cam.lookat = point3(278, 278, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        sc = make_scene(world, std::move(materials), cam, accel);
+        return true;
+    }
+
+    // count instances of a few shared meshes scattered over a plane, each with its own rotation and
+    // non-uniform scale. the meshes are stored once, an instance costs its 100 bytes and its share of the
+    // top-level nodes
+    inline scene instanced_field(int count, accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto ground = materials.add(lambertian(textures.add(checker_texture(4, textures.add(solid_color(0.2, 0.3, 0.1)),
+                                                                                 textures.add(solid_color(0.9, 0.9, 0.9))))));
+        world.add(make_shared<quad>(point3(-1000, 0, -1000), vec3(2000, 0, 0), vec3(0, 0, 2000), ground));
+
+        auto start = std::chrono::steady_clock::now();
+        auto field = make_shared<instance_bvh>();
+        std::vector<shared_ptr<triangle_mesh>> meshes = {
+            make_shared<triangle_mesh>(mesh_data::torus(0.35, 64, 32), materials.add(metal(color(0.8, 0.6, 0.2), 0.1))),
+            make_shared<triangle_mesh>(mesh_data::sphere(32, 64), materials.add(lambertian(textures.add(solid_color(0.7, 0.2, 0.2))))),
+            make_shared<triangle_mesh>(mesh_data::box(point3(-1, -1, -1), point3(1, 1, 1)),
+                                       materials.add(lambertian(textures.add(solid_color(0.2, 0.3, 0.7))))),
+        };
+        std::vector<uint32_t> geometries;
+        size_t mesh_bytes = 0, triangles = 0;
+        for (const auto& mesh : meshes) {
+            geometries.push_back(field->add_geometry(mesh));
+            mesh_bytes += mesh->memory_bytes();
+            triangles += mesh->triangle_count();
+        }
+        // any hittable can be shared, here an analytic sphere that instances scale into ellipsoids
+        geometries.push_back(field->add_geometry(make_shared<sphere>(point3(0, 0, 0), 1, materials.add(dielectric(1.5)))));
+
+        double half_extent = 0.75 * std::sqrt(static_cast<double>(count));
+        for (int i = 0; i < count; i++) {
+            auto geometry = geometries[static_cast<size_t>(random_int(0, static_cast<int>(geometries.size()) - 1))];
+            vec3 axis = vec3::random(-1, 1);
+            auto shape = affine_transform::rotation(axis, random_double(0, 360)) *
+                         affine_transform::scaling(vec3(random_double(0.2, 0.5), random_double(0.2, 0.5), random_double(0.2, 0.5)));
+            // rest the instance on the ground
+            double lift = -shape.bounds(aabb(point3(-1, -1, -1), point3(1, 1, 1))).y.min;
+            vec3 position(random_double(-half_extent, half_extent), lift, random_double(-half_extent, half_extent));
+            field->add_instance(geometry, affine_transform::translation(position) * shape);
+        }
+        field->build();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        const auto& stats = field->build_stats();
+        std::clog << "Instances: " << field->instance_count() << " of " << field->geometry_count() << " geometries ("
+                  << triangles << " mesh triangles, " << mesh_bytes / (1024.0 * 1024.0) << " MiB), "
+                  << field->memory_bytes() / (1024.0 * 1024.0) << " MiB for the instances and " << stats.node_count
+                  << " top-level nodes (" << static_cast<double>(field->memory_bytes()) / std::max<size_t>(1, field->instance_count())
+                  << " bytes per instance), built in " << elapsed.count() << " ms" << std::endl;
+        world.add(field);
+
+        camera cam;
+
+        cam.aspect_ratio = 16.0 / 9.0;
+        cam.image_width = 600;
+        cam.samples_per_pixel = 64;
+        cam.max_depth = 20;
+        cam.background = color(0.70, 0.80, 1.00);
+
+        cam.vfov = 30;
+        cam.lookfrom = point3(0, 6, -half_extent - 4);
+        cam.lookat = point3(0, 0, -half_extent + 20);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    inline scene cornell_smoke(accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto red = materials.add(lambertian(textures.add(solid_color(.65, 0.05, 0.05))));
+        auto white = materials.add(lambertian(textures.add(solid_color(.73, .73, .73))));
+        auto green = materials.add(lambertian(textures.add(solid_color(0.12, 0.45, 0.15))));
+        auto light = materials.add(diffuse_light(textures.add(solid_color(7, 7, 7))));
+
+        world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), green));
+        world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), red));
+        world.add(make_shared<quad>(point3(113, 554, 128), vec3(330, 0, 0), vec3(0, 0, 305), light));
+        world.add(make_shared<quad>(point3(0, 555, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+        world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+        world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 555, 0), white));
+        
+        auto box1 = place(box(point3(0, 0, 0), point3(165, 330, 165), white),
+                          affine_transform::translation(vec3(265, 0, 295)) * affine_transform::rotation_y(15));
+        world.add(box1);
+
+        auto box2 = place(box(point3(0, 0, 0), point3(165, 165, 165), white),
+                          affine_transform::translation(vec3(130, 0, 65)) * affine_transform::rotation_y(-18));
+        world.add(box2);
+
+        world.add(make_shared<constant_medium>(box1, 0.01, materials.add(isotropic(textures.add(solid_color(0, 0, 0))))));
+        world.add(make_shared<constant_medium>(box2, 0.01, materials.add(isotropic(textures.add(solid_color(1, 1, 1))))));
+
+        camera cam;
+
+        cam.aspect_ratio = 1.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.0, 0.0, 0.0);
+
+        cam.vfov = 40;
+        cam.lookfrom = point3(278, 278, -800);
+        cam.lookat = point3(278, 278, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    // the cornell box around a cloud: a sphere of noise_texture density, baked into a 64^3 grid and tracked
+    // through 16^3 majorant cells
+    inline scene cornell_cloud(accel_type accel) {
+        hittable_list world;
+        material_table materials;
+        auto& textures = materials.textures;
+
+        auto red = materials.add(lambertian(textures.add(solid_color(.65, 0.05, 0.05))));
+        auto white = materials.add(lambertian(textures.add(solid_color(.73, .73, .73))));
+        auto green = materials.add(lambertian(textures.add(solid_color(0.12, 0.45, 0.15))));
+        auto light = materials.add(diffuse_light(textures.add(solid_color(7, 7, 7))));
+
+        world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), green));
+        world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0), vec3(0, 0, 555), red));
+        world.add(make_shared<quad>(point3(113, 554, 128), vec3(330, 0, 0), vec3(0, 0, 305), light));
+        world.add(make_shared<quad>(point3(0, 555, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+        world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0), vec3(0, 0, 555), white));
+        world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0), vec3(0, 555, 0), white));
+
+        // the marble of noise_texture, stretched so its veins span the cloud. raised to the fourth power, the
+        // veins stand out against thin gaps: extinction from 0 to 0.05 per unit
+        auto boundary = make_shared<sphere>(point3(278, 240, 278), 180, white);
+        noise_texture marble(4);
+        density_grid density(boundary->bounding_box(), 64, [&](const point3& p) {
+            double v = marble.value(0, 0, p / 90).x();
+            return 0.05 * v * v * v * v;
+        });
+        auto cloud = materials.add(isotropic(textures.add(solid_color(0.9, 0.9, 0.9))));
+        world.add(make_shared<heterogeneous_medium>(boundary, std::move(density), cloud));
+
+        camera cam;
+
+        cam.aspect_ratio = 1.0;
+        cam.image_width = 400;
+        cam.samples_per_pixel = 100;
+        cam.max_depth = 50;
+        cam.background = color(0.0, 0.0, 0.0);
+
+        cam.vfov = 40;
+        cam.lookfrom = point3(278, 278, -800);
+        cam.lookat = point3(278, 278, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+
+    inline scene final_scene(int image_width, int samples_per_pixel, int max_depth, accel_type accel) {
+        material_table materials;
+        auto& textures = materials.textures;
+
+        hittable_list boxes1;
+
+        auto ground = materials.add(lambertian(textures.add(solid_color(0.48, 0.83, 0.53))));
+
+        int boxes_per_size = 20;
+        for (int i = 0; i < boxes_per_size; i++) {
+            for (int j = 0; j < boxes_per_size; j++) {
+                auto w = 100.0;
+                auto x0 = -1000.0 + i * w;
+                auto z0 = -1000.0 + j * w;
+                auto y0 = 0.0;
+                auto x1 = x0 + w;
+                auto y1 = random_double(1, 101);
+                auto z1 = z0 + w;
+
+                boxes1.add(box(point3(x0, y0, z0), point3(x1, y1, z1), ground));
+            }
+        }
+
+        hittable_list world;
+
+        world.add(make_accel(boxes1, accel));
+
+        auto light = materials.add(diffuse_light(textures.add(solid_color(7, 7, 7))));
+        world.add(make_shared<quad>(point3(123, 554, 147), vec3(300, 0, 0), vec3(0, 0, 265), light));
+
+        auto center1 = point3(400, 400, 200);
+        auto center2 = center1 + vec3(30, 0, 0);
+        auto sphere_material = materials.add(lambertian(textures.add(solid_color(0.1, 0.5, 0.5))));
+        world.add(make_shared<sphere>(center1, center2, 50, sphere_material));
+
+        world.add(make_shared<sphere>(point3(260, 150, 45), 50, materials.add(dielectric(1.5))));
+
+        world.add(make_shared<sphere>(point3(0, 150, 145), 50, materials.add(metal(color(0.8, 0.8, 0.9), 0.0))));
+
+        auto boundary = make_shared<sphere>(point3(360, 150, 145), 70, materials.add(dielectric(1.5)));
+        world.add(boundary);
+        world.add(make_shared<constant_medium>(boundary, 0.2, materials.add(isotropic(textures.add(solid_color(0.2, 0.4, 0.9))))));
+        boundary = make_shared<sphere>(point3(0, 0, 0), 5000, materials.add(lambertian(textures.add(solid_color(0.5, 0.5, 0.5)))));
+        world.add(make_shared<constant_medium>(boundary, 0.0001, materials.add(isotropic(textures.add(solid_color(1, 1, 1))))));
+
+        auto emat = materials.add(lambertian(textures.add(image_texture("earthmap.jpg", textures.cache()))));
+        world.add(make_shared<sphere>(point3(400, 200, 420), 30, emat));
+        auto pertext = textures.add(noise_texture(0.2));
+        world.add(make_shared<sphere>(point3(220, 280, 300), 30, materials.add(lambertian(pertext))));
+
+        hittable_list boxes2;
+        auto white = materials.add(lambertian(textures.add(solid_color(.73, .73, .73))));
+        int ns = 1000;
+        for (int i = 0; i < ns; i++) {
+            boxes2.add(make_shared<sphere>(point3::random(0, 165), 10, white));
+        }
+
+        world.add(place(make_accel(boxes2, accel), affine_transform::translation(vec3(-100, 270, 395)) * affine_transform::rotation_y(15)));
+
+        camera cam;
+
+        cam.aspect_ratio = 1.0;
+        cam.image_width = image_width;
+        cam.samples_per_pixel = samples_per_pixel;
+        cam.max_depth = max_depth;
+        cam.background = color(0.0, 0.0, 0.0);
+
+        cam.vfov = 40;
+        cam.lookfrom = point3(478, 278, -600);
+        cam.lookat = point3(278, 278, 0);
+        cam.vup = vec3(0, 1, 0);
+
+        cam.defocus_angle = 0;
+
+        return make_scene(world, std::move(materials), cam, accel);
+    }
+}
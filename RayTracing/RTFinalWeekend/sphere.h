@@ -1,84 +1,136 @@
-#pragma once
-#include "hittable.h"
-#include "vec3.h"
-#include "ray.h"
-#include "aabb.h"
-
-namespace My {
-    class sphere : public hittable {
-        public:
-            // stationary sphere
-            sphere(const point3& static_center, double radius, shared_ptr<material> mat)
-                : center(static_center, vec3(0, 0, 0)), radius(std::fmax(0, radius)), mat(mat)
-            {
-                auto rvec = vec3(radius, radius, radius);
-                bbox = aabb(static_center - rvec, static_center + rvec);
-            }
-            
-            // moving sphere
-            sphere(const point3& center1, const point3& center2, double radius, shared_ptr<material> mat) 
-                : center(center1, center2 - center1), radius(std::fmax(0, radius)), mat(mat)
-            {
-                auto rvec = vec3(radius, radius, radius);
-                aabb box1(center.at(0) - rvec, center.at(0) + rvec);
-                aabb box2(center.at(1) - rvec, center.at(1) + rvec);
-                bbox = aabb(box1, box2);
-            }
-
-            bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
-                // ray-sphere intersection 
-                //P(t) = origin + t * direction | x^2 + y^2 + z^2 = radius^2
-                // (origin + t * direction - center)^2 = radius^2
-                // t^2 * direction^2 + 2t * direction * (origin - center) + (origin - center)^2 - radius^2 = 0
-                // at^2 + bt + c = 0
-                point3 current_center = center.at(r.time());
-                vec3 oc = current_center - r.origin();
-                auto a = dot(r.direction(), r.direction());
-                auto h = dot(oc, r.direction());
-                auto c = dot(oc, oc) - radius * radius;
-
-                auto discriminant = h*h - a*c;
-                if (discriminant < 0)
-                    return false;
-
-                auto sqrtd = std::sqrt(discriminant);
-                // find the root
-                auto root = (h - sqrtd) / a;
-                if (ray_t.surrounds(root)) {
-                    root = (h + sqrtd) / a;
-                    if (ray_t.surrounds(root))
-                        return false;
-                }
-
-                rec.t = root;
-                rec.p = r.at(rec.t);
-                vec3 outward_normal = (rec.p - current_center) / radius;
-                rec.set_face_normal(r, outward_normal);
-                get_sphere_uv(outward_normal, rec.u, rec.v);
-                rec.mat = mat;
-
-                return true;
-            }
-
-            aabb bounding_box() const override { return bbox; }
-
-        private:
-            static void get_sphere_uv(const point3& p, double& u, double& v) {
-                // p: a given point on the sphere of radius one, centered at the origin
-                // u: returned value [0, 1] of angle around the Y axis from x = -1
-                // v: returned value [0, 1] of angle from y = -1 to y = 1
-
-                auto theta = std::acos(-p.y());
-                auto phi = std::atan2(-p.z(), p.x()) + pi;
-
-                u = phi / (2 * pi);
-                v = theta / pi;
-            }
-
-        private:
-            ray center;
-            double radius;
-            shared_ptr<material> mat;
-            aabb bbox;
-    };
+#pragma once
+#include "hittable.h"
+#include "vec3.h"
+#include "ray.h"
+#include "aabb.h"
+
+namespace My {
+    class geometry_store;
+    class light_list;
+
+    class sphere : public hittable {
+        friend class geometry_store;
+        friend class light_list;
+
+        public:
+            // stationary sphere
+            sphere(const point3& static_center, double radius, material_id mat)
+                : center(static_center, vec3(0, 0, 0)), radius(std::fmax(0, radius)), mat(mat)
+            {
+                auto rvec = vec3(radius, radius, radius);
+                bbox = aabb(static_center - rvec, static_center + rvec);
+            }
+            
+            // moving sphere
+            sphere(const point3& center1, const point3& center2, double radius, material_id mat) 
+                : center(center1, center2 - center1), radius(std::fmax(0, radius)), mat(mat)
+            {
+                auto rvec = vec3(radius, radius, radius);
+                aabb box1(center.at(0) - rvec, center.at(0) + rvec);
+                aabb box2(center.at(1) - rvec, center.at(1) + rvec);
+                bbox = aabb(box1, box2);
+            }
+
+            bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+                // ray-sphere intersection 
+                //P(t) = origin + t * direction | x^2 + y^2 + z^2 = radius^2
+                // (origin + t * direction - center)^2 = radius^2
+                // t^2 * direction^2 + 2t * direction * (origin - center) + (origin - center)^2 - radius^2 = 0
+                // at^2 + bt + c = 0
+                RT_COUNT(primitive_tests);
+                double near_root, far_root;
+                if (!solve(r, near_root, far_root))
+                    return false;
+
+                // find the root
+                auto root = near_root;
+                if (ray_t.surrounds(root)) {
+                    root = far_root;
+                    if (ray_t.surrounds(root))
+                        return false;
+                }
+
+                rec.t = root;
+                rec.surface = this;
+
+                RT_COUNT(primitive_hits);
+                return true;
+            }
+
+            void set_surface(const ray& r, hit_record& rec) const override {
+                rec.p = r.at(rec.t);
+                vec3 outward_normal = (rec.p - center.at(r.time())) / radius;
+                rec.set_face_normal(r, outward_normal);
+                get_sphere_uv(outward_normal, rec.u, rec.v);
+                get_sphere_partials(radius * outward_normal, rec.dpdu, rec.dpdv);
+                rec.mat = mat;
+            }
+
+            // same root search as hit, without the hit point, normal and uv
+            bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+                RT_COUNT(primitive_tests);
+                double near_root, far_root;
+                return RT_COUNT_HIT(solve(r, near_root, far_root) && (ray_t.contains(near_root) || ray_t.contains(far_root)));
+            }
+
+            // both roots of one solve
+            bool crossings(const ray& r, double& enter, double& exit, sampler& s) const override {
+                RT_COUNT(primitive_tests);
+                return RT_COUNT_HIT(solve(r, enter, exit));
+            }
+
+            aabb bounding_box() const override { return bbox; }
+
+            aabb bounds_at(double time) const override {
+                auto rvec = vec3(radius, radius, radius);
+                return aabb(center.at(time) - rvec, center.at(time) + rvec);
+            }
+
+        private:
+            // the roots in double whatever real is. from a point on a large sphere, like the ground of most scenes,
+            // oc is long and c nearly cancels; in float that error would outgrow the offset of the ray's origin
+            bool solve(const ray& r, double& near_root, double& far_root) const {
+                using dvec3 = basic_vec3<double>;
+                dvec3 direction(r.direction());
+                dvec3 oc = dvec3(center.origin()) + double(r.time()) * dvec3(center.direction()) - dvec3(r.origin());
+                auto a = dot(direction, direction);
+                auto h = dot(oc, direction);
+                auto c = dot(oc, oc) - radius * radius;
+
+                auto discriminant = h*h - a*c;
+                if (discriminant < 0)
+                    return false;
+
+                auto sqrtd = std::sqrt(discriminant);
+                near_root = (h - sqrtd) / a;
+                far_root = (h + sqrtd) / a;
+                return true;
+            }
+
+            static void get_sphere_uv(const point3& p, double& u, double& v) {
+                // p: a given point on the sphere of radius one, centered at the origin
+                // u: returned value [0, 1] of angle around the Y axis from x = -1
+                // v: returned value [0, 1] of angle from y = -1 to y = 1
+
+                auto theta = std::acos(-p.y());
+                auto phi = std::atan2(-p.z(), p.x()) + pi;
+
+                u = phi / (2 * pi);
+                v = theta / pi;
+            }
+
+            // the derivatives of the get_sphere_uv mapping at p, a point relative to the center. at the poles
+            // u has no effect and the distance from the axis is kept off zero
+            static void get_sphere_partials(const vec3& p, vec3& dpdu, vec3& dpdv) {
+                double axis_distance = std::fmax(std::sqrt(p.x() * p.x() + p.z() * p.z()), 1e-12);
+                dpdu = 2 * pi * vec3(p.z(), 0, -p.x());
+                dpdv = pi * vec3(-p.x() * p.y() / axis_distance, axis_distance, -p.y() * p.z() / axis_distance);
+            }
+
+        private:
+            ray center;
+            double radius;
+            material_id mat;
+            aabb bbox;
+    };
 }
\ No newline at end of file
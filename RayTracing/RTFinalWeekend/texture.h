@@ -1,94 +1,165 @@
-#pragma once
-
-#include "color.h"
-#include "vec3.h"
-#include "perlin.h"
-#include "rtw_stb_image.h"
-
-namespace My
-{
-    class texture
-    {
-    public:
-        virtual ~texture() = default;
-
-        virtual color value(double u, double v, const point3& p) const = 0;
-    };
-
-    class solid_color : public texture
-    {
-    public:
-        solid_color(const color& albedo) : albedo(albedo) {}
-
-        solid_color(double red, double green, double blue) : solid_color(color(red, green, blue)) {}
-
-        color value(double u, double v, const point3& p) const override {
-            return albedo;
-        }
-
-    private:
-        color albedo;
-    };
-
-    class checker_texture : public texture
-    {
-    public:
-        checker_texture(double scale, std::shared_ptr<texture> event, std::shared_ptr<texture> odd)
-            : inv_scale(1.0 / scale), even(event), odd(odd) {}
-
-        checker_texture(double scale, const color& c1, const color& c2)
-            : checker_texture(scale, std::make_shared<solid_color>(c1), std::make_shared<solid_color>(c2)) {}
-
-        color value(double u, double v, const point3& p) const override {
-            auto xInteger = int(std::floor(inv_scale * p.x()));
-            auto yInteger = int(std::floor(inv_scale * p.y()));
-            auto zInteger = int(std::floor(inv_scale * p.z()));
-
-            bool isEven = (xInteger + yInteger + zInteger) % 2 == 0;
-            return isEven ? even->value(u, v, p) : odd->value(u, v, p);
-        }
-        
-    private:
-        double inv_scale;
-        std::shared_ptr<texture> even;
-        std::shared_ptr<texture> odd;
-    };
-
-    class image_texture : public texture 
-    {
-    public:
-        image_texture(const char* filename) : image(filename) {}
-
-        color value(double u, double v, const point3& p) const override {
-            if (image.height() <= 0) return color(0, 1, 1);
-
-            // clamp input texture coordinates to [0, 1] x [1, 0]
-            u = interval(0, 1).clamp(u);
-            v = 1.0 - interval(0, 1).clamp(v);
-
-            auto i = int(u * image.width());
-            auto j = int(v * image.height());
-            auto pixel = image.pixel_data(i, j);
-
-            auto color_scale = 1.0 / 255.0;
-            return color(pixel[0] * color_scale, pixel[1] * color_scale, pixel[2] * color_scale);
-        }
-
-    private:
-        rtw_image image;
-    };
-
-    class noise_texture : public texture
-    {
-    public:
-        noise_texture(double sc) : scale(sc) {}
-
-        color value(double u, double v, const point3& p) const override {
-            return color(0.5, 0.5, 0.5) * (1 + std::sin(scale * p.z() + 10 * noise.turb(p, 7)));
-        }
-
-    private:
-        perlin noise;
-        double scale;
-    };
-}
+#pragma once
+
+#include "color.h"
+#include "ray.h"
+#include "vec3.h"
+#include "perlin.h"
+#include "rtw_stb_image.h"
+#include "texture_cache.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace My
+{
+    // index of a texture in its texture_table
+    using texture_id = uint32_t;
+
+    class solid_color
+    {
+    public:
+        solid_color(const color& albedo) : albedo(albedo) {}
+
+        solid_color(double red, double green, double blue) : solid_color(color(red, green, blue)) {}
+
+        color value(double u, double v, const point3& p) const {
+            return albedo;
+        }
+
+    private:
+        color albedo;
+    };
+
+    // picks between two other textures of the same table in a 3d checker pattern
+    class checker_texture
+    {
+    public:
+        checker_texture(double scale, texture_id even, texture_id odd)
+            : inv_scale(1.0 / scale), even(even), odd(odd) {}
+
+        texture_id select(const point3& p) const {
+            auto xInteger = int(std::floor(inv_scale * p.x()));
+            auto yInteger = int(std::floor(inv_scale * p.y()));
+            auto zInteger = int(std::floor(inv_scale * p.z()));
+
+            bool isEven = (xInteger + yInteger + zInteger) % 2 == 0;
+            return isEven ? even : odd;
+        }
+        
+    private:
+        double inv_scale;
+        texture_id even;
+        texture_id odd;
+    };
+
+    // an image filtered to the area a pixel covers: bilinear within a mip level, and linear between the two
+    // levels whose texel size brackets the footprint (trilinear). an unknown footprint (all zero, as for
+    // rays after the first bounce) is filtered bilinearly at full resolution. the texels come from the
+    // tiles of a texture_cache, which has to outlive the texture
+    class image_texture
+    {
+    public:
+        image_texture(const char* filename, texture_cache& cache) : cache(&cache), handle(cache.open(filename)) {}
+
+        color value(double u, double v, const point3& p, const uv_footprint& footprint = {}) const {
+            if (handle < 0) return color(0, 1, 1);
+
+            // clamp input texture coordinates to [0, 1] x [1, 0]
+            u = interval(0, 1).clamp(u);
+            v = 1.0 - interval(0, 1).clamp(v);
+
+            // the longer of the two pixel steps, in texels of level 0
+            const tiled_texture_level& base = cache->level(handle, 0);
+            double w = base.width, h = base.height;
+            double step_x = std::hypot(footprint.dudx * w, footprint.dvdx * h);
+            double step_y = std::hypot(footprint.dudy * w, footprint.dvdy * h);
+            double step = std::fmax(step_x, step_y);
+
+            texture_cache::cursor c;
+            if (!(step > 1))
+                return bilinear(c, 0, u, v);
+
+            int level_count = cache->level_count(handle);
+            double lod = std::fmin(std::log2(step), level_count - 1);
+            int level = static_cast<int>(lod);
+            double t = lod - level;
+            if (t == 0 || level + 1 >= level_count)
+                return bilinear(c, level, u, v);
+            return (1 - t) * bilinear(c, level, u, v) + t * bilinear(c, level + 1, u, v);
+        }
+
+    private:
+        texture_cache* cache;
+        int handle;
+
+        // texel centers sit at half-integer coordinates, lookups past the edge clamp
+        color bilinear(texture_cache::cursor& c, int level, double u, double v) const {
+            const tiled_texture_level& lv = cache->level(handle, level);
+            double x = u * lv.width - 0.5, y = v * lv.height - 0.5;
+            double fx = std::floor(x), fy = std::floor(y);
+            int i = static_cast<int>(fx), j = static_cast<int>(fy);
+            double tx = x - fx, ty = y - fy;
+
+            auto texel = [&](int a, int b) {
+                auto pixel = cache->texel(c, handle, level, a, b);
+                return color(rtw_image::to_linear(pixel[0]), rtw_image::to_linear(pixel[1]), rtw_image::to_linear(pixel[2]));
+            };
+            return (1 - ty) * ((1 - tx) * texel(i, j) + tx * texel(i + 1, j)) +
+                   ty * ((1 - tx) * texel(i, j + 1) + tx * texel(i + 1, j + 1));
+        }
+    };
+
+    // the perlin tables are a few kilobytes, so they live out of line: kept inline they would size every
+    // alternative of texture, and with it each solid color in the table, to match
+    class noise_texture
+    {
+    public:
+        noise_texture(double sc) : noise(std::make_shared<const perlin>()), scale(sc) {}
+
+        color value(double u, double v, const point3& p) const {
+            return color(0.5, 0.5, 0.5) * (1 + std::sin(scale * p.z() + 10 * noise->turb(p, 7)));
+        }
+
+    private:
+        std::shared_ptr<const perlin> noise;
+        double scale;
+    };
+
+    using texture = std::variant<solid_color, checker_texture, image_texture, noise_texture>;
+
+    // all textures of a scene in one flat array, addressed by id
+    class texture_table
+    {
+    public:
+        texture_id add(texture tex) {
+            textures.push_back(std::move(tex));
+            return static_cast<texture_id>(textures.size() - 1);
+        }
+
+        // footprint is how far u and v move per pixel at this lookup, which only image textures use
+        color value(texture_id id, double u, double v, const point3& p, const uv_footprint& footprint = {}) const {
+            return std::visit([&](const auto& tex) -> color {
+                using T = std::decay_t<decltype(tex)>;
+                if constexpr (std::is_same_v<T, checker_texture>)
+                    return value(tex.select(p), u, v, p, footprint);
+                else if constexpr (std::is_same_v<T, image_texture>)
+                    return tex.value(u, v, p, footprint);
+                else
+                    return tex.value(u, v, p);
+            }, textures[id]);
+        }
+
+        size_t size() const { return textures.size(); }
+
+        // the tiles of the table's image textures
+        texture_cache& cache() const { return *tiles; }
+
+    private:
+        std::vector<texture> textures;
+        std::shared_ptr<texture_cache> tiles = std::make_shared<texture_cache>();
+    };
+}
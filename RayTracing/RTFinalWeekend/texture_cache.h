@@ -0,0 +1,350 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "rtw_stb_image.h"
+#include "sampler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace My
+{
+    // tiled texture file: this header, the level table, then the tiles from tile_offset on. every mip level is
+    // cut into tile_size squares of rgb bytes, stored level after level and row after row; tiles over the edge
+    // of a level repeat its last texel. source_size and source_time tell whether the file still matches its image
+    struct tiled_texture_header
+    {
+        char magic[8];
+        uint64_t source_size;
+        int64_t source_time;
+        uint32_t width;
+        uint32_t height;
+        uint32_t level_count;
+        uint32_t tile_size;
+        uint64_t tile_offset;
+    };
+
+    struct tiled_texture_level
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t tiles_x;
+        uint32_t tiles_y;
+        uint64_t first_tile;      // index among all tiles of the file
+    };
+
+    inline const char* tiled_texture_magic() { return "RTTILES1"; }
+
+    struct texture_cache_stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t map_failures = 0;  // spans that could not be mapped, whose texels read as magenta
+        size_t resident_bytes = 0;
+        size_t peak_bytes = 0;
+        size_t budget_bytes = 0;
+    };
+
+    // image textures read through this cache instead of keeping their images in memory. open converts an image
+    // once into a tiled texture file in RTW_TEXTURE_CACHE (or rtw_textures in the temporary directory); after
+    // that a texture costs its level table, and a span of tiles is mapped when a lookup first needs one of them.
+    // mapped spans count against the budget, and the least recently used are unmapped to stay under it. textures
+    // are opened while the scene is built, lookups are thread safe
+    class texture_cache
+    {
+    public:
+        static constexpr int tile_size = 64;
+        static constexpr size_t tile_bytes = tile_size * tile_size * 3;     // three pages of 4 KiB
+        // tiles are mapped a span of consecutive ones at a time, a strip along a row of the level, so a budget
+        // of gigabytes still takes thousands of mappings rather than the hundreds of thousands one per tile would
+        static constexpr int span_tiles = 16;
+        // at most this many spans stay mapped whatever the budget, half of linux's default vm.max_map_count
+        static constexpr size_t max_spans = 32768;
+        static constexpr size_t default_budget = 64u << 20;
+
+        using span_ref = std::shared_ptr<const mapped_view>;
+
+        // the last span one filter footprint used; its texels mostly share a span and skip the cache's lock.
+        // the cursor keeps its span mapped, so it should not outlive the lookup
+        struct cursor
+        {
+            uint64_t key = ~uint64_t(0);
+            span_ref span;
+        };
+
+        explicit texture_cache(size_t budget_bytes = default_budget) : budget(budget_bytes) {}
+
+        texture_cache(const texture_cache&) = delete;
+        texture_cache& operator=(const texture_cache&) = delete;
+
+        void set_budget(size_t bytes) {
+            std::lock_guard<std::mutex> guard(lock);
+            budget = bytes;
+            while (!lru.empty() && counts.resident_bytes > budget)
+                evict_last();
+        }
+
+        // a handle for the image, converting it first if there is no current tiled file; -1 if it can't be loaded.
+        // opening the same image again returns the same handle
+        int open(const char* filename) {
+            namespace fs = std::filesystem;
+            std::lock_guard<std::mutex> guard(lock);
+
+            std::string source = rtw_image::find(filename);
+            if (source.empty()) {
+                std::cerr << "Failed to load image file: " << filename << std::endl;
+                return -1;
+            }
+
+            std::error_code ec;
+            std::string key = fs::absolute(source, ec).string();
+            if (ec) key = source;
+            auto known = opened.find(key);
+            if (known != opened.end())
+                return known->second;
+
+            uint64_t source_size = fs::file_size(source, ec);
+            if (ec) source_size = 0;
+            int64_t source_time = static_cast<int64_t>(fs::last_write_time(source, ec).time_since_epoch().count());
+            if (ec) source_time = 0;
+
+            std::string path = tiled_path(key);
+            auto file = std::make_unique<tiled_file>();
+            if (!file->open(path, source_size, source_time)) {
+                rtw_image image;
+                if (!image.load(source)) {
+                    std::cerr << "Failed to load image file: " << filename << std::endl;
+                    return -1;
+                }
+                if (!write_tiled(image, source_size, source_time, path) || !file->open(path, source_size, source_time)) {
+                    std::cerr << "ERROR: could not write tiled texture '" << path << "'.\n";
+                    return -1;
+                }
+                std::clog << "Converted " << source << " to tiled texture " << path << std::endl;
+            }
+
+            files.push_back(std::move(file));
+            int handle = static_cast<int>(files.size() - 1);
+            opened.emplace(key, handle);
+            return handle;
+        }
+
+        int level_count(int texture) const { return static_cast<int>(files[texture]->levels.size()); }
+        const tiled_texture_level& level(int texture, int l) const { return files[texture]->levels[l]; }
+
+        // the texel at x, y of a mip level, clamped to its edges; magenta if its tiles can't be mapped.
+        // the pointer stays valid while the cursor holds on to the span
+        const unsigned char* texel(cursor& c, int texture, int l, int x, int y) {
+            static const unsigned char magenta[] = { 255, 0, 255 };
+            const tiled_file& file = *files[texture];
+            const tiled_texture_level& lv = file.levels[l];
+            x = std::clamp(x, 0, static_cast<int>(lv.width) - 1);
+            y = std::clamp(y, 0, static_cast<int>(lv.height) - 1);
+
+            uint64_t index = lv.first_tile + static_cast<uint64_t>(y / tile_size) * lv.tiles_x + x / tile_size;
+            uint64_t span = index / span_tiles;
+            uint64_t key = (static_cast<uint64_t>(texture) << 40) | span;
+            if (key != c.key) {
+                c.span = fetch(file, key, span);
+                c.key = key;
+            }
+            if (!*c.span)
+                return magenta;
+
+            size_t offset = static_cast<size_t>(index - span * span_tiles) * tile_bytes +
+                            (static_cast<size_t>(y % tile_size) * tile_size + x % tile_size) * 3;
+            return reinterpret_cast<const unsigned char*>(c.span->data()) + offset;
+        }
+
+        texture_cache_stats stats() const {
+            std::lock_guard<std::mutex> guard(lock);
+            texture_cache_stats s = counts;
+            s.budget_bytes = budget;
+            return s;
+        }
+
+    private:
+        struct tiled_file
+        {
+            paged_file data;
+            std::vector<tiled_texture_level> levels;
+            uint64_t tile_offset = 0;
+            uint64_t tile_count = 0;
+
+            // false unless path is a complete tiled texture of the source as it is now
+            bool open(const std::string& path, uint64_t source_size, int64_t source_time) {
+                if (!data.open(path) || data.size() < sizeof(tiled_texture_header))
+                    return false;
+
+                mapped_view start = data.map(0, sizeof(tiled_texture_header));
+                if (!start)
+                    return false;
+                tiled_texture_header header;
+                std::memcpy(&header, start.data(), sizeof(header));
+                if (std::memcmp(header.magic, tiled_texture_magic(), sizeof(header.magic)) != 0 ||
+                    header.source_size != source_size || header.source_time != source_time ||
+                    header.tile_size != tile_size || header.level_count == 0 || header.level_count > 32)
+                    return false;
+
+                size_t table_bytes = header.level_count * sizeof(tiled_texture_level);
+                mapped_view table = data.map(sizeof(header), table_bytes);
+                if (!table)
+                    return false;
+                levels.resize(header.level_count);
+                std::memcpy(levels.data(), table.data(), table_bytes);
+
+                const tiled_texture_level& last = levels.back();
+                tile_count = last.first_tile + static_cast<uint64_t>(last.tiles_x) * last.tiles_y;
+                tile_offset = header.tile_offset;
+                return data.size() >= tile_offset + tile_count * tile_bytes;
+            }
+        };
+
+        struct entry
+        {
+            uint64_t key;
+            span_ref span;
+            size_t bytes;
+        };
+
+        mutable std::mutex lock;
+        size_t budget;
+        std::vector<std::unique_ptr<tiled_file>> files;
+        std::unordered_map<std::string, int> opened;
+        std::list<entry> lru;       // most recently used first
+        std::unordered_map<uint64_t, std::list<entry>::iterator> entries;
+        texture_cache_stats counts;
+
+        span_ref fetch(const tiled_file& file, uint64_t key, uint64_t span) {
+            std::lock_guard<std::mutex> guard(lock);
+            auto found = entries.find(key);
+            if (found != entries.end()) {
+                counts.hits++;
+                lru.splice(lru.begin(), lru, found->second);
+                return found->second->span;
+            }
+
+            // room first, so the new mapping does not add to a full address space
+            uint64_t first = span * span_tiles;
+            size_t bytes = static_cast<size_t>(std::min<uint64_t>(span_tiles, file.tile_count - first)) * tile_bytes;
+            counts.misses++;
+            while (!lru.empty() && (counts.resident_bytes + bytes > budget || lru.size() >= max_spans))
+                evict_last();
+
+            auto view = std::make_shared<const mapped_view>(file.data.map(file.tile_offset + first * tile_bytes, bytes));
+            if (!*view) {
+                if (counts.map_failures++ == 0)
+                    std::cerr << "ERROR: could not map texture tiles, their texels render magenta.\n";
+                return view;
+            }
+
+            lru.push_front({ key, view, bytes });
+            entries.emplace(key, lru.begin());
+            counts.resident_bytes += bytes;
+            counts.peak_bytes = std::max(counts.peak_bytes, counts.resident_bytes);
+            return view;
+        }
+
+        // a cursor still holding the span keeps it mapped until it moves on
+        void evict_last() {
+            entries.erase(lru.back().key);
+            counts.resident_bytes -= lru.back().bytes;
+            lru.pop_back();
+            counts.evictions++;
+        }
+
+        std::string tiled_path(const std::string& source) const {
+            namespace fs = std::filesystem;
+            std::error_code ec;
+            fs::path dir;
+            char* cachedir = nullptr;
+            size_t len;
+            _dupenv_s(&cachedir, &len, "RTW_TEXTURE_CACHE");
+            if (cachedir != nullptr) {
+                dir = cachedir;
+                free(cachedir);
+            } else {
+                dir = fs::temp_directory_path(ec) / "rtw_textures";
+            }
+            fs::create_directories(dir, ec);
+
+            // the name keeps the image's for readability, the hash tells images of the same name apart
+            char hash[17];
+            std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(mix_bits(std::hash<std::string>()(source))));
+            return (dir / (fs::path(source).stem().string() + "-" + hash + ".tiles")).string();
+        }
+
+        // written to a temporary file that then replaces path, like a checkpoint
+        static bool write_tiled(const rtw_image& image, uint64_t source_size, int64_t source_time, const std::string& path) {
+            tiled_texture_header header = {};
+            std::memcpy(header.magic, tiled_texture_magic(), sizeof(header.magic));
+            header.source_size = source_size;
+            header.source_time = source_time;
+            header.width = static_cast<uint32_t>(image.width());
+            header.height = static_cast<uint32_t>(image.height());
+            header.level_count = static_cast<uint32_t>(image.level_count());
+            header.tile_size = tile_size;
+
+            std::vector<tiled_texture_level> levels(header.level_count);
+            uint64_t tile_count = 0;
+            for (int l = 0; l < image.level_count(); l++) {
+                auto& lv = levels[l];
+                lv.width = static_cast<uint32_t>(image.level_info(l).width);
+                lv.height = static_cast<uint32_t>(image.level_info(l).height);
+                lv.tiles_x = (lv.width + tile_size - 1) / tile_size;
+                lv.tiles_y = (lv.height + tile_size - 1) / tile_size;
+                lv.first_tile = tile_count;
+                tile_count += static_cast<uint64_t>(lv.tiles_x) * lv.tiles_y;
+            }
+
+            // tiles start on a page, so a tile's mapping never takes in the table
+            size_t table_end = sizeof(header) + levels.size() * sizeof(tiled_texture_level);
+            header.tile_offset = (table_end + 4095) / 4096 * 4096;
+
+            std::string temp_path = path + ".tmp";
+            {
+                mapped_file file;
+                if (!file.create(temp_path, header.tile_offset + tile_count * tile_bytes))
+                    return false;
+
+                char* out = file.data();
+                std::memcpy(out, &header, sizeof(header));
+                std::memcpy(out + sizeof(header), levels.data(), levels.size() * sizeof(tiled_texture_level));
+
+                for (int l = 0; l < image.level_count(); l++) {
+                    const auto& lv = levels[l];
+                    for (uint32_t ty = 0; ty < lv.tiles_y; ty++) {
+                        for (uint32_t tx = 0; tx < lv.tiles_x; tx++) {
+                            char* tile = out + header.tile_offset + (lv.first_tile + ty * lv.tiles_x + tx) * tile_bytes;
+                            for (int y = 0; y < tile_size; y++) {
+                                for (int x = 0; x < tile_size; x++) {
+                                    // pixel_data clamps to the level, which repeats the edge
+                                    const unsigned char* pixel = image.pixel_data(tx * tile_size + x, ty * tile_size + y, l);
+                                    std::memcpy(tile + (y * tile_size + x) * 3, pixel, 3);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                if (!file.flush())
+                    return false;
+            }
+
+            return replace_file(temp_path, path);
+        }
+    };
+}
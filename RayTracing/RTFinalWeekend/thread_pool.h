@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace My
+{
+    // runs batches of indexed tasks on a set of worker threads, started once with the pool and parked
+    // between batches. every worker owns a deque seeded with a contiguous block of a batch's tasks, pops
+    // from its front, and once it runs dry steals from the back of the other workers' deques.
+    // one batch runs at a time: parallel_for must not be called from two threads, or from inside a task
+    class thread_pool
+    {
+    public:
+        // thread_count <= 0 uses every hardware thread
+        explicit thread_pool(int thread_count = 0) {
+            if (thread_count <= 0)
+                thread_count = static_cast<int>(std::thread::hardware_concurrency());
+            worker_count = std::max(1, thread_count);
+
+            queues = std::vector<task_queue>(worker_count);
+            threads.reserve(worker_count - 1);
+            for (int w = 1; w < worker_count; w++)
+                threads.emplace_back([this, w] { work(w); });
+        }
+
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+            batch_ready.notify_all();
+            for (auto& t : threads)
+                t.join();
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        int size() const { return worker_count; }
+
+        // calls fn(task_index, worker_index) for every task in [0, task_count) and returns when all are done.
+        // the calling thread works as worker 0.
+        template <typename F>
+        void parallel_for(int task_count, F&& fn) {
+            int workers = std::min(worker_count, task_count);
+            if (workers <= 1) {
+                for (int task = 0; task < task_count; task++)
+                    fn(task, 0);
+                return;
+            }
+
+            for (int w = 0; w < workers; w++) {
+                int begin = static_cast<int>(static_cast<long long>(task_count) * w / workers);
+                int end = static_cast<int>(static_cast<long long>(task_count) * (w + 1) / workers);
+                for (int task = begin; task < end; task++)
+                    queues[w].tasks.push_back(task);
+            }
+
+            // the workers reach fn through a plain function pointer, so a batch costs no allocation
+            using function = std::remove_reference_t<F>;
+            auto call = [](void* context, int task, int w) { (*static_cast<function*>(context))(task, w); };
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                batch_call = call;
+                batch_context = const_cast<void*>(static_cast<const void*>(&fn));
+                batch_workers = workers;
+                busy = workers - 1;
+                generation++;
+            }
+            batch_ready.notify_all();
+
+            run(0);
+
+            std::unique_lock<std::mutex> guard(lock);
+            batch_done.wait(guard, [&] { return busy == 0; });
+        }
+
+    private:
+        struct task_queue {
+            std::mutex lock;
+            std::deque<int> tasks;
+        };
+
+        int worker_count;
+        std::vector<task_queue> queues;
+        std::vector<std::thread> threads;
+
+        // the current batch, guarded by lock
+        std::mutex lock;
+        std::condition_variable batch_ready;
+        std::condition_variable batch_done;
+        void (*batch_call)(void*, int, int) = nullptr;
+        void* batch_context = nullptr;
+        int batch_workers = 0;
+        int busy = 0;                   // workers besides the caller still running the batch
+        unsigned generation = 0;
+        bool stopping = false;
+
+        void run(int w) {
+            int task;
+            while (pop_front(queues[w], task) || steal(w, task))
+                batch_call(batch_context, task, w);
+        }
+
+        // waits for every batch after the ones it has seen; workers past a small batch's count sit it out
+        void work(int w) {
+            unsigned seen = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    batch_ready.wait(guard, [&] { return stopping || generation != seen; });
+                    if (stopping)
+                        return;
+                    seen = generation;
+                    if (w >= batch_workers)
+                        continue;
+                }
+
+                run(w);
+
+                std::lock_guard<std::mutex> guard(lock);
+                if (--busy == 0)
+                    batch_done.notify_one();
+            }
+        }
+
+        static bool pop_front(task_queue& q, int& task) {
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty()) return false;
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+
+        bool steal(int thief, int& task) {
+            int n = batch_workers;
+            for (int k = 1; k < n; k++) {
+                auto& victim = queues[(thief + k) % n];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (victim.tasks.empty()) continue;
+                task = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
+            }
+            return false;
+        }
+    };
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "rtweekend.h"
+
+#include "aabb.h"
+
+#include <cmath>
+
+namespace My
+{
+    // an affine map x -> A x + b, stored as the three rows of the 3x4 matrix [A | b]
+    class affine_transform
+    {
+    public:
+        double m[3][4];
+
+        affine_transform() : m{ { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } {}
+
+        static affine_transform translation(const vec3& offset) {
+            affine_transform t;
+            for (int i = 0; i < 3; i++) t.m[i][3] = offset[i];
+            return t;
+        }
+
+        static affine_transform scaling(const vec3& factors) {
+            affine_transform t;
+            for (int i = 0; i < 3; i++) t.m[i][i] = factors[i];
+            return t;
+        }
+
+        static affine_transform scaling(double factor) { return scaling(vec3(factor, factor, factor)); }
+
+        // counterclockwise around axis when it points at the viewer, rodrigues' formula
+        static affine_transform rotation(const vec3& axis, double degrees) {
+            vec3 a = unit_vector(axis);
+            double radians = degrees_to_radians(degrees);
+            double c = std::cos(radians), s = std::sin(radians), k = 1 - c;
+            affine_transform t;
+            t.m[0][0] = c + a.x() * a.x() * k;
+            t.m[0][1] = a.x() * a.y() * k - a.z() * s;
+            t.m[0][2] = a.x() * a.z() * k + a.y() * s;
+            t.m[1][0] = a.y() * a.x() * k + a.z() * s;
+            t.m[1][1] = c + a.y() * a.y() * k;
+            t.m[1][2] = a.y() * a.z() * k - a.x() * s;
+            t.m[2][0] = a.z() * a.x() * k - a.y() * s;
+            t.m[2][1] = a.z() * a.y() * k + a.x() * s;
+            t.m[2][2] = c + a.z() * a.z() * k;
+            return t;
+        }
+
+        // the same as rotate_y: rotation(vec3(0, 1, 0), degrees)
+        static affine_transform rotation_y(double degrees) { return rotation(vec3(0, 1, 0), degrees); }
+
+        // applies other first, then this
+        affine_transform operator*(const affine_transform& other) const {
+            affine_transform t;
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 4; j++) {
+                    t.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j];
+                }
+                t.m[i][3] += m[i][3];
+            }
+            return t;
+        }
+
+        // A must be invertible; the inverse maps x -> A^-1 x - A^-1 b
+        affine_transform inverse() const {
+            affine_transform t;
+            double det = determinant();
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    // the cofactor of m[j][i] over the determinant
+                    int r0 = (j + 1) % 3, r1 = (j + 2) % 3, c0 = (i + 1) % 3, c1 = (i + 2) % 3;
+                    t.m[i][j] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / det;
+                }
+            }
+            for (int i = 0; i < 3; i++)
+                t.m[i][3] = -(t.m[i][0] * m[0][3] + t.m[i][1] * m[1][3] + t.m[i][2] * m[2][3]);
+            return t;
+        }
+
+        double determinant() const {
+            return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                   m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                   m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        }
+
+        point3 point(const point3& p) const {
+            return point3(row(0, p) + m[0][3], row(1, p) + m[1][3], row(2, p) + m[2][3]);
+        }
+
+        vec3 vector(const vec3& v) const { return vec3(row(0, v), row(1, v), row(2, v)); }
+
+        // the box around the transformed box, per axis the translation plus the extremes of each
+        // column's contribution (arvo), which gives the same box as transforming all eight corners
+        aabb bounds(const aabb& box) const {
+            if (box.x.min > box.x.max || box.y.min > box.y.max || box.z.min > box.z.max)
+                return aabb::empty;
+            point3 lo, hi;
+            for (int i = 0; i < 3; i++) {
+                lo[i] = hi[i] = m[i][3];
+                for (int j = 0; j < 3; j++) {
+                    double a = m[i][j] * box.axis_interval(j).min;
+                    double b = m[i][j] * box.axis_interval(j).max;
+                    lo[i] += std::fmin(a, b);
+                    hi[i] += std::fmax(a, b);
+                }
+            }
+            return aabb(lo, hi);
+        }
+
+    private:
+        double row(int i, const vec3& v) const { return m[i][0] * v.x() + m[i][1] * v.y() + m[i][2] * v.z(); }
+    };
+}
@@ -0,0 +1,350 @@
+#pragma once
+
+#include "bvh_builder.h"
+#include "hittable.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace My
+{
+    // the shared arrays of a triangle mesh. like obj, every triangle corner indexes the positions,
+    // normals and uvs separately; normals and uvs are optional, a corner without one has the index none
+    struct mesh_data
+    {
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        std::vector<float> positions;           // xyz per vertex
+        std::vector<float> normals;             // xyz per normal
+        std::vector<float> uvs;                 // uv per texture vertex
+        std::vector<uint32_t> position_indices; // three per triangle
+        std::vector<uint32_t> normal_indices;   // three per triangle, or empty
+        std::vector<uint32_t> uv_indices;       // three per triangle, or empty
+
+        size_t vertex_count() const { return positions.size() / 3; }
+        size_t triangle_count() const { return position_indices.size() / 3; }
+
+        point3 position(uint32_t i) const {
+            return point3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+        }
+
+        aabb bounds() const {
+            aabb box = aabb::empty;
+            for (size_t i = 0; i < vertex_count(); i++) {
+                point3 p = position(static_cast<uint32_t>(i));
+                box = aabb(box, aabb(p, p));
+            }
+            return box;
+        }
+
+        // scales by scale around the origin, then moves by offset
+        void transform(double scale, const vec3& offset) {
+            for (size_t i = 0; i < positions.size(); i++)
+                positions[i] = static_cast<float>(positions[i] * scale + offset[i % 3]);
+        }
+
+        void add_position(const point3& p) {
+            for (int i = 0; i < 3; i++) positions.push_back(static_cast<float>(p[i]));
+        }
+
+        void add_triangle(uint32_t a, uint32_t b, uint32_t c) {
+            position_indices.insert(position_indices.end(), { a, b, c });
+        }
+
+        // the box with opposite corners a and b, two triangles per face
+        static mesh_data box(const point3& a, const point3& b) {
+            mesh_data mesh;
+            for (int i = 0; i < 8; i++)
+                mesh.add_position(point3(i & 1 ? b.x() : a.x(), i & 2 ? b.y() : a.y(), i & 4 ? b.z() : a.z()));
+            static const uint32_t faces[6][4] = { { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 },
+                                                  { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+            for (const auto& f : faces) {
+                mesh.add_triangle(f[0], f[1], f[2]);
+                mesh.add_triangle(f[0], f[2], f[3]);
+            }
+            return mesh;
+        }
+
+        // a unit sphere around the origin cut into rings and segments, with smooth normals
+        static mesh_data sphere(int rings, int segments) {
+            mesh_data mesh;
+            for (int i = 0; i <= rings; i++) {
+                double theta = pi * i / rings;
+                for (int j = 0; j <= segments; j++) {
+                    double phi = 2 * pi * j / segments;
+                    mesh.add_position(point3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+                }
+            }
+            mesh.normals = mesh.positions;
+            auto row = static_cast<uint32_t>(segments + 1);
+            for (uint32_t i = 0; i < static_cast<uint32_t>(rings); i++) {
+                for (uint32_t j = 0; j < static_cast<uint32_t>(segments); j++) {
+                    uint32_t a = i * row + j, b = a + row;
+                    if (i > 0) mesh.add_triangle(a, a + 1, b);
+                    if (i + 1 < static_cast<uint32_t>(rings)) mesh.add_triangle(a + 1, b + 1, b);
+                }
+            }
+            mesh.normal_indices = mesh.position_indices;
+            return mesh;
+        }
+
+        // a torus around the y axis: major radius 1, tube radius minor, with smooth normals
+        static mesh_data torus(double minor, int rings, int segments) {
+            mesh_data mesh;
+            for (int i = 0; i <= rings; i++) {
+                double phi = 2 * pi * i / rings;
+                vec3 center(std::cos(phi), 0, std::sin(phi));
+                for (int j = 0; j <= segments; j++) {
+                    double theta = 2 * pi * j / segments;
+                    vec3 n = std::cos(theta) * center + vec3(0, std::sin(theta), 0);
+                    mesh.add_position(center + minor * n);
+                    for (int k = 0; k < 3; k++) mesh.normals.push_back(static_cast<float>(n[k]));
+                }
+            }
+            auto row = static_cast<uint32_t>(segments + 1);
+            for (uint32_t i = 0; i < static_cast<uint32_t>(rings); i++) {
+                for (uint32_t j = 0; j < static_cast<uint32_t>(segments); j++) {
+                    uint32_t a = i * row + j, b = a + row;
+                    mesh.add_triangle(a, a + 1, b + 1);
+                    mesh.add_triangle(a, b + 1, b);
+                }
+            }
+            mesh.normal_indices = mesh.position_indices;
+            return mesh;
+        }
+    };
+
+    // triangles over shared vertex arrays with a bvh of their own, one material for the whole mesh.
+    // the intersection is woop, benthin and wald's watertight test: the ray is sheared onto the z axis, so a
+    // ray through an edge or vertex shared by two triangles can not slip between them
+    class triangle_mesh : public hittable
+    {
+    public:
+        // a triangle test costs about as much as a node test, so mesh leaves may hold more primitives
+        static bvh_builder default_builder() {
+            bvh_builder builder;
+            builder.traversal_cost = 1;
+            builder.max_leaf_size = 16;
+            return builder;
+        }
+
+        triangle_mesh(mesh_data data, material_id mat, const bvh_builder& builder = default_builder())
+            : mesh(std::move(data)), mat(mat)
+        {
+            size_t count = mesh.triangle_count();
+            std::vector<aabb> bounds(count);
+            for (size_t i = 0; i < count; i++) {
+                const uint32_t* v = &mesh.position_indices[3 * i];
+                point3 p0 = mesh.position(v[0]), p1 = mesh.position(v[1]), p2 = mesh.position(v[2]);
+                bounds[i] = aabb(aabb(p0, p1), aabb(p2, p2));
+            }
+
+            std::vector<uint32_t> order;
+            nodes = builder.build(bounds, order, &stats);
+            bbox = count > 0 ? mesh.bounds() : aabb::empty;
+
+            // reorder the triangles to leaf order, so a leaf addresses a range of them directly
+            reorder(mesh.position_indices, order);
+            reorder(mesh.normal_indices, order);
+            reorder(mesh.uv_indices, order);
+        }
+
+        bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            triangle_ray tr(r);
+            const point3& origin = r.origin();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            bool hit_anything = false;
+
+            traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const linear_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, ray_t.min, ray_t.max); },
+                [&](const linear_bvh_node& node) {
+                    for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                        double t, b1, b2;
+                        if (intersect(tr, i, ray_t, t, b1, b2)) {
+                            hit_anything = true;
+                            ray_t.max = t;
+                            rec.t = t;
+                            rec.u = b1;
+                            rec.v = b2;
+                            rec.primitive = i;
+                        }
+                    }
+                    return false;
+                });
+
+            if (hit_anything)
+                rec.surface = this;
+            return hit_anything;
+        }
+
+        bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            triangle_ray tr(r);
+            const point3& origin = r.origin();
+            vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+            int dir_is_neg[3] = { inv_dir.x() < 0, inv_dir.y() < 0, inv_dir.z() < 0 };
+
+            return traverse_bvh(nodes.data(), dir_is_neg,
+                [&](const linear_bvh_node& node) { return node.hit(origin, inv_dir, dir_is_neg, ray_t.min, ray_t.max); },
+                [&](const linear_bvh_node& node) {
+                    for (uint32_t i = node.offset; i < node.offset + node.count; i++) {
+                        double t, b1, b2;
+                        if (intersect(tr, i, ray_t, t, b1, b2))
+                            return true;
+                    }
+                    return false;
+                });
+        }
+
+        // rec.u and rec.v hold the barycentrics of the second and third corner until here
+        void set_surface(const ray& r, hit_record& rec) const override {
+            uint32_t tri = rec.primitive;
+            double b1 = rec.u, b2 = rec.v, b0 = 1 - b1 - b2;
+            const uint32_t* v = &mesh.position_indices[3 * tri];
+            point3 p0 = mesh.position(v[0]);
+
+            rec.p = r.at(rec.t);
+            rec.mat = mat;
+            vec3 e1 = mesh.position(v[1]) - p0, e2 = mesh.position(v[2]) - p0;
+            rec.set_face_normal(r, unit_vector(cross(e1, e2)));
+
+            if (has_all(mesh.normal_indices, tri)) {
+                const uint32_t* n = &mesh.normal_indices[3 * tri];
+                vec3 shading = unit_vector(b0 * normal(n[0]) + b1 * normal(n[1]) + b2 * normal(n[2]));
+                // interpolated normals keep to the side the ray sees
+                rec.normal = dot(shading, rec.normal) < 0 ? -shading : shading;
+            }
+
+            if (has_all(mesh.uv_indices, tri)) {
+                const uint32_t* t = &mesh.uv_indices[3 * tri];
+                const float* uvs = mesh.uvs.data();
+                rec.u = b0 * uvs[2 * t[0]] + b1 * uvs[2 * t[1]] + b2 * uvs[2 * t[2]];
+                rec.v = b0 * uvs[2 * t[0] + 1] + b1 * uvs[2 * t[1] + 1] + b2 * uvs[2 * t[2] + 1];
+
+                // the edges are linear in the uv steps along them, which gives dpdu and dpdv unless the uvs are degenerate
+                double du1 = uvs[2 * t[1]] - uvs[2 * t[0]], dv1 = uvs[2 * t[1] + 1] - uvs[2 * t[0] + 1];
+                double du2 = uvs[2 * t[2]] - uvs[2 * t[0]], dv2 = uvs[2 * t[2] + 1] - uvs[2 * t[0] + 1];
+                double det = du1 * dv2 - dv1 * du2;
+                if (det != 0) {
+                    rec.dpdu = (dv2 * e1 - dv1 * e2) / det;
+                    rec.dpdv = (du1 * e2 - du2 * e1) / det;
+                } else {
+                    rec.dpdu = rec.dpdv = vec3(0, 0, 0);
+                }
+            } else {
+                // u and v stay the barycentrics of the second and third corner
+                rec.dpdu = e1;
+                rec.dpdv = e2;
+            }
+        }
+
+        aabb bounding_box() const override { return bbox; }
+
+        size_t triangle_count() const { return mesh.triangle_count(); }
+        size_t vertex_count() const { return mesh.vertex_count(); }
+        size_t node_count() const { return nodes.size(); }
+
+        const bvh_build_stats& build_stats() const { return stats; }
+
+        // bytes of the vertex, index and node arrays
+        size_t memory_bytes() const {
+            return (mesh.positions.size() + mesh.normals.size() + mesh.uvs.size()) * sizeof(float) +
+                   (mesh.position_indices.size() + mesh.normal_indices.size() + mesh.uv_indices.size()) * sizeof(uint32_t) +
+                   nodes.size() * sizeof(linear_bvh_node);
+        }
+
+    private:
+        // the per-ray part of the watertight test: kz is the dominant axis of the direction, kx and ky the other
+        // two (swapped to keep the winding when the direction along kz is negative), s the shear onto z
+        struct triangle_ray
+        {
+            point3 origin;
+            int kx, ky, kz;
+            double sx, sy, sz;
+
+            explicit triangle_ray(const ray& r) : origin(r.origin()) {
+                const vec3& d = r.direction();
+                kz = std::fabs(d.x()) > std::fabs(d.y()) ? (std::fabs(d.x()) > std::fabs(d.z()) ? 0 : 2)
+                                                         : (std::fabs(d.y()) > std::fabs(d.z()) ? 1 : 2);
+                kx = (kz + 1) % 3;
+                ky = (kx + 1) % 3;
+                if (d[kz] < 0) std::swap(kx, ky);
+                sx = d[kx] / d[kz];
+                sy = d[ky] / d[kz];
+                sz = 1.0 / d[kz];
+            }
+        };
+
+        mesh_data mesh;
+        material_id mat;
+        std::vector<linear_bvh_node> nodes;
+        aabb bbox;
+        bvh_build_stats stats;
+
+        vec3 normal(uint32_t i) const {
+            return vec3(mesh.normals[3 * i], mesh.normals[3 * i + 1], mesh.normals[3 * i + 2]);
+        }
+
+        // both faces count. b1 and b2 are the barycentrics of the second and third corner
+        bool intersect(const triangle_ray& tr, uint32_t tri, const interval& ray_t, double& t, double& b1, double& b2) const {
+            RT_COUNT(primitive_tests);
+            const uint32_t* corner = &mesh.position_indices[3 * tri];
+            vec3 a = mesh.position(corner[0]) - tr.origin;
+            vec3 b = mesh.position(corner[1]) - tr.origin;
+            vec3 c = mesh.position(corner[2]) - tr.origin;
+
+            double ax = a[tr.kx] - tr.sx * a[tr.kz], ay = a[tr.ky] - tr.sy * a[tr.kz];
+            double bx = b[tr.kx] - tr.sx * b[tr.kz], by = b[tr.ky] - tr.sy * b[tr.kz];
+            double cx = c[tr.kx] - tr.sx * c[tr.kz], cy = c[tr.ky] - tr.sy * c[tr.kz];
+
+            // the scaled barycentrics are edge functions; an edge shared by two triangles gives exactly
+            // negated values in both, so a hit on it is never lost
+            double u = cx * by - cy * bx;
+            double v = ax * cy - ay * cx;
+            double w = bx * ay - by * ax;
+            if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0))
+                return false;
+
+            double det = u + v + w;
+            if (det == 0)
+                return false;
+
+            double inv_det = 1.0 / det;
+            t = (u * a[tr.kz] + v * b[tr.kz] + w * c[tr.kz]) * tr.sz * inv_det;
+            if (!ray_t.contains(t))
+                return false;
+
+            b1 = v * inv_det;
+            b2 = w * inv_det;
+            RT_COUNT(primitive_hits);
+            return true;
+        }
+
+        // whether all three corners of the triangle have an entry in the optional indices
+        static bool has_all(const std::vector<uint32_t>& indices, uint32_t tri) {
+            return !indices.empty() && indices[3 * tri] != mesh_data::none && indices[3 * tri + 1] != mesh_data::none &&
+                   indices[3 * tri + 2] != mesh_data::none;
+        }
+
+        static void reorder(std::vector<uint32_t>& indices, const std::vector<uint32_t>& order) {
+            if (indices.empty())
+                return;
+            std::vector<uint32_t> sorted(indices.size());
+            for (size_t i = 0; i < order.size(); i++) {
+                sorted[3 * i] = indices[3 * order[i]];
+                sorted[3 * i + 1] = indices[3 * order[i] + 1];
+                sorted[3 * i + 2] = indices[3 * order[i] + 2];
+            }
+            indices.swap(sorted);
+        }
+    };
+}
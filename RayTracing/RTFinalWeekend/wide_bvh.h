@@ -0,0 +1,306 @@
+#pragma once
+#include "aabb.h"
+#include "bvh_builder.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RT_BVH4_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace My
+{
+    // four children per node, bounds stored as structure of arrays so one slab test covers all of them.
+    // an empty slot has inverted bounds and never passes the test
+    struct alignas(16) bvh4_node
+    {
+        float lo[3][4];         // per axis, the min bound of the four children
+        float hi[3][4];
+        uint32_t child[4];      // interior: node index, leaf: first primitive
+        uint16_t count[4];      // primitives in a leaf child, 0 for interior children
+        uint32_t pad[2];
+
+        const float* bounds(int axis, bool max_side) const {
+            return max_side ? hi[axis] : lo[axis];
+        }
+    };
+
+    static_assert(sizeof(bvh4_node) == 128, "bvh4_node should stay two cache lines");
+
+    // 4-wide bvh collapsed from the binary sah tree. traversal tests the four child boxes of a node at once
+    // (sse where available, a scalar loop otherwise) and pushes the hit children nearest last, so they pop first
+    class bvh4 : public hittable
+    {
+    public:
+        bvh4(const hittable_list& list, const bvh_builder& builder = bvh_builder()) {
+            std::vector<aabb> bounds;
+            bounds.reserve(list.objects.size());
+            for (const auto& object : list.objects)
+                bounds.push_back(object->bounding_box());
+
+            std::vector<uint32_t> order;
+            auto binary = builder.build(bounds, order, &stats);
+
+            primitives.reserve(order.size());
+            for (auto index : order)
+                primitives.push_back(list.objects[index]);
+
+            if (!binary.empty()) {
+                nodes.reserve(binary.size() / 2 + 1);
+                if (binary[0].is_leaf()) {
+                    nodes.emplace_back();
+                    clear_node(nodes[0]);
+                    set_slot(nodes[0], 0, binary[0], binary[0].offset);
+                } else {
+                    collapse(binary, 0);
+                }
+            }
+
+            bbox = list.bounding_box();
+        }
+
+        bool hit(const ray& r, interval ray_t, hit_record& rec, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            ray_data rd(r);
+            float t_min = linear_bvh_node::round_down(ray_t.min);
+            float t_max = linear_bvh_node::round_up(ray_t.max);
+
+            stack_entry stack[stack_capacity];
+            int stack_size = 0;
+            stack[stack_size++] = { 0, 0, static_cast<float>(ray_t.min) };
+            bool hit_anything = false;
+
+            while (stack_size > 0) {
+                auto entry = stack[--stack_size];
+                if (entry.t_near > ray_t.max)
+                    continue;
+
+                if (entry.count > 0) {
+                    for (uint32_t i = 0; i < entry.count; i++) {
+                        if (primitives[entry.child + i]->hit(r, ray_t, rec, s)) {
+                            hit_anything = true;
+                            ray_t.max = rec.t;
+                            t_max = linear_bvh_node::round_up(ray_t.max);
+                        }
+                    }
+                    continue;
+                }
+
+                const bvh4_node& node = nodes[entry.child];
+                RT_COUNT(node_visits);
+                float t_near[4];
+                int mask = intersect(node, rd, t_min, t_max, t_near);
+                if (mask == 0)
+                    continue;
+
+                // insertion sort the hit children by distance, farthest first
+                stack_entry hits[4];
+                int hit_count = 0;
+                for (int k = 0; k < 4; k++) {
+                    if (!(mask & (1 << k))) continue;
+                    stack_entry e = { node.child[k], node.count[k], t_near[k] };
+                    int j = hit_count++;
+                    while (j > 0 && hits[j - 1].t_near < e.t_near) {
+                        hits[j] = hits[j - 1];
+                        j--;
+                    }
+                    hits[j] = e;
+                }
+                for (int k = 0; k < hit_count; k++)
+                    stack[stack_size++] = hits[k];
+            }
+
+            return hit_anything;
+        }
+
+        // any hit ends the query, so children are pushed unsorted and the interval never shrinks
+        bool occluded(const ray& r, interval ray_t, sampler& s) const override {
+            if (nodes.empty())
+                return false;
+
+            ray_data rd(r);
+            float t_min = linear_bvh_node::round_down(ray_t.min);
+            float t_max = linear_bvh_node::round_up(ray_t.max);
+
+            stack_entry stack[stack_capacity];
+            int stack_size = 0;
+            stack[stack_size++] = { 0, 0, static_cast<float>(ray_t.min) };
+
+            while (stack_size > 0) {
+                auto entry = stack[--stack_size];
+
+                if (entry.count > 0) {
+                    for (uint32_t i = 0; i < entry.count; i++) {
+                        if (primitives[entry.child + i]->occluded(r, ray_t, s))
+                            return true;
+                    }
+                    continue;
+                }
+
+                const bvh4_node& node = nodes[entry.child];
+                RT_COUNT(node_visits);
+                float t_near[4];
+                int mask = intersect(node, rd, t_min, t_max, t_near);
+                for (int k = 0; k < 4; k++) {
+                    if (mask & (1 << k))
+                        stack[stack_size++] = { node.child[k], node.count[k], t_near[k] };
+                }
+            }
+
+            return false;
+        }
+
+        aabb bounding_box() const override { return bbox; }
+
+        size_t node_count() const { return nodes.size(); }
+
+        const bvh_build_stats& build_stats() const { return stats; }
+
+    private:
+        static constexpr int stack_capacity = 256;
+
+        struct stack_entry {
+            uint32_t child;
+            uint32_t count;
+            float t_near;
+        };
+
+        // per-ray constants in float. the origin is rounded to both sides so the near and far
+        // distances can each use the conservative one
+        struct ray_data {
+            float inv_dir[3];
+            float origin_near[3];
+            float origin_far[3];
+            int dir_is_neg[3];
+
+            explicit ray_data(const ray& r) {
+                for (int a = 0; a < 3; a++) {
+                    double inv = 1.0 / r.direction()[a];
+                    inv_dir[a] = static_cast<float>(inv);
+                    dir_is_neg[a] = inv < 0;
+                    float lo = linear_bvh_node::round_down(r.origin()[a]);
+                    float hi = linear_bvh_node::round_up(r.origin()[a]);
+                    origin_near[a] = dir_is_neg[a] ? lo : hi;
+                    origin_far[a] = dir_is_neg[a] ? hi : lo;
+                }
+            }
+        };
+
+        // widens the far distance by 2 * gamma(3) to cover the float rounding of the slab test
+        static constexpr float far_scale = 1.0f + 2.0f * (3 * 0.5f * std::numeric_limits<float>::epsilon());
+
+        std::vector<bvh4_node> nodes;
+        std::vector<shared_ptr<hittable>> primitives;
+        aabb bbox;
+        bvh_build_stats stats;
+
+        // returns a bit mask of the children whose box overlaps [t_min, t_max], with their entry distances in t_near
+        static int intersect(const bvh4_node& node, const ray_data& rd, float t_min, float t_max, float t_near[4]) {
+            RT_COUNT_N(box_tests, 4);
+#ifdef RT_BVH4_SSE
+            __m128 near_t = _mm_set1_ps(t_min);
+            __m128 far_t = _mm_set1_ps(t_max);
+            for (int a = 2; a >= 0; a--) {
+                __m128 inv = _mm_set1_ps(rd.inv_dir[a]);
+                __m128 b_near = _mm_load_ps(node.bounds(a, rd.dir_is_neg[a]));
+                __m128 b_far = _mm_load_ps(node.bounds(a, !rd.dir_is_neg[a]));
+                __m128 t0 = _mm_mul_ps(_mm_sub_ps(b_near, _mm_set1_ps(rd.origin_near[a])), inv);
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(b_far, _mm_set1_ps(rd.origin_far[a])), inv);
+                // maxps/minps return the second operand when either is NaN, so a 0 * inf slab is ignored
+                near_t = _mm_max_ps(t0, near_t);
+                far_t = _mm_min_ps(t1, far_t);
+            }
+            far_t = _mm_mul_ps(far_t, _mm_set1_ps(far_scale));
+            _mm_storeu_ps(t_near, near_t);
+            return _mm_movemask_ps(_mm_cmple_ps(near_t, far_t));
+#else
+            int mask = 0;
+            for (int k = 0; k < 4; k++) {
+                float near_t = t_min;
+                float far_t = t_max;
+                for (int a = 0; a < 3; a++) {
+                    float t0 = (node.bounds(a, rd.dir_is_neg[a])[k] - rd.origin_near[a]) * rd.inv_dir[a];
+                    float t1 = (node.bounds(a, !rd.dir_is_neg[a])[k] - rd.origin_far[a]) * rd.inv_dir[a];
+                    if (t0 > near_t) near_t = t0;
+                    if (t1 < far_t) far_t = t1;
+                }
+                t_near[k] = near_t;
+                if (near_t <= far_t * far_scale)
+                    mask |= 1 << k;
+            }
+            return mask;
+#endif
+        }
+
+        static void clear_node(bvh4_node& node) {
+            const float inf = std::numeric_limits<float>::infinity();
+            for (int k = 0; k < 4; k++) {
+                for (int a = 0; a < 3; a++) {
+                    node.lo[a][k] = inf;
+                    node.hi[a][k] = -inf;
+                }
+                node.child[k] = 0;
+                node.count[k] = 0;
+            }
+            node.pad[0] = node.pad[1] = 0;
+        }
+
+        static void set_slot(bvh4_node& node, int k, const linear_bvh_node& src, uint32_t child) {
+            for (int a = 0; a < 3; a++) {
+                node.lo[a][k] = src.bounds_min[a];
+                node.hi[a][k] = src.bounds_max[a];
+            }
+            node.child[k] = child;
+            node.count[k] = src.count;
+        }
+
+        static double area(const linear_bvh_node& n) {
+            double dx = double(n.bounds_max[0]) - n.bounds_min[0];
+            double dy = double(n.bounds_max[1]) - n.bounds_min[1];
+            double dz = double(n.bounds_max[2]) - n.bounds_min[2];
+            return dx * dy + dy * dz + dz * dx;
+        }
+
+        // pulls up to four descendants of a binary interior node into one wide node,
+        // always opening the interior child with the largest surface area
+        uint32_t collapse(const std::vector<linear_bvh_node>& binary, uint32_t index) {
+            uint32_t kids[4] = { index + 1, binary[index].offset, 0, 0 };
+            int kid_count = 2;
+
+            while (kid_count < 4) {
+                int best = -1;
+                double best_area = -1;
+                for (int k = 0; k < kid_count; k++) {
+                    const auto& n = binary[kids[k]];
+                    if (!n.is_leaf() && area(n) > best_area) {
+                        best_area = area(n);
+                        best = k;
+                    }
+                }
+                if (best < 0) break;
+
+                uint32_t opened = kids[best];
+                kids[best] = opened + 1;
+                kids[kid_count++] = binary[opened].offset;
+            }
+
+            auto node_index = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+            clear_node(nodes[node_index]);
+
+            for (int k = 0; k < kid_count; k++) {
+                const auto& n = binary[kids[k]];
+                uint32_t child = n.is_leaf() ? n.offset : collapse(binary, kids[k]);
+                set_slot(nodes[node_index], k, n, child);
+            }
+
+            return node_index;
+        }
+    };
+}
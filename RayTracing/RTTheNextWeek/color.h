@@ -1,30 +1,30 @@
-#pragma once
-
-#include "vec3.h"
-#include "interval.h"
-
-namespace My {
-    using color = vec3;
-    
-    inline double linear_to_gamma(double linear_component) {
-        return linear_component > 0 ? std::sqrt(linear_component) : 0;
-    }
-
-    void write_color(std::ostream& out, const color& pixel_color) {
-        auto r = pixel_color.x();
-        auto g = pixel_color.y();
-        auto b = pixel_color.z();
-
-        // apply a linear to gamma transform for gamma 2
-        r = linear_to_gamma(r);
-        g = linear_to_gamma(g);
-        b = linear_to_gamma(b);
-        
-        static const interval intensity(0.000, 0.999);
-        int rbyte = int(256 * intensity.clamp(r));
-        int gbyte = int(256 * intensity.clamp(g));
-        int bbyte = int(256 * intensity.clamp(b));
-    
-        out << rbyte << ' ' << gbyte << ' ' << bbyte << '\n';
-    }
+#pragma once
+
+#include "vec3.h"
+#include "interval.h"
+
+namespace My {
+    using color = vec3;
+    
+    inline double linear_to_gamma(double linear_component) {
+        return linear_component > 0 ? std::sqrt(linear_component) : 0;
+    }
+
+    void write_color(std::ostream& out, const color& pixel_color) {
+        auto r = pixel_color.x();
+        auto g = pixel_color.y();
+        auto b = pixel_color.z();
+
+        // apply a linear to gamma transform for gamma 2
+        r = linear_to_gamma(r);
+        g = linear_to_gamma(g);
+        b = linear_to_gamma(b);
+        
+        static const interval intensity(0.000, 0.999);
+        int rbyte = int(256 * intensity.clamp(r));
+        int gbyte = int(256 * intensity.clamp(g));
+        int bbyte = int(256 * intensity.clamp(b));
+    
+        out << rbyte << ' ' << gbyte << ' ' << bbyte << '\n';
+    }
 }
\ No newline at end of file
@@ -1,37 +1,47 @@
-#pragma once
-
-#include <cmath>
-#include <iostream>
-#include <limits>
-#include <memory>
-#include <random>
-
-using std::make_shared;
-using std::shared_ptr;
-
-const double infinity = std::numeric_limits<double>::infinity();
-const double pi = 3.1415926535897932385;
-
-inline double degrees_to_radians(double degrees) {
-    return degrees * pi / 180.0;
-}
-
-inline double random_double() {
-    static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    static std::mt19937 generator;
-    return distribution(generator);
-}
-
-inline double random_double(double min, double max) {
-    return min + (max - min) * random_double();
-}
-
-inline int random_int(int min, int max) {
-    return static_cast<int>(random_double(min, max + 1));
-}
-
-#include "color.h"
-#include "ray.h"
-#include "vec3.h"
-#include "interval.h"
+#pragma once
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+
+using std::make_shared;
+using std::shared_ptr;
+
+const double infinity = std::numeric_limits<double>::infinity();
+const double pi = 3.1415926535897932385;
+
+inline double degrees_to_radians(double degrees) {
+    return degrees * pi / 180.0;
+}
+
+// each thread draws from its own generator, so render workers never share state
+inline std::mt19937& random_generator() {
+    thread_local std::mt19937 generator;
+    return generator;
+}
+
+// restart the calling thread's sequence, e.g. per pixel so an image does not depend on which thread rendered it
+inline void seed_random(unsigned int seed) {
+    random_generator().seed(seed);
+}
+
+inline double random_double() {
+    thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    return distribution(random_generator());
+}
+
+inline double random_double(double min, double max) {
+    return min + (max - min) * random_double();
+}
+
+inline int random_int(int min, int max) {
+    return static_cast<int>(random_double(min, max + 1));
+}
+
+#include "color.h"
+#include "ray.h"
+#include "vec3.h"
+#include "interval.h"
 #include "camera.h"
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace My
+{
+    // runs a batch of indexed tasks on a set of worker threads.
+    // every worker owns a deque seeded with a contiguous block of the tasks, pops from its front,
+    // and once it runs dry steals from the back of the other workers' deques.
+    class thread_pool
+    {
+    public:
+        // thread_count <= 0 uses every hardware thread
+        explicit thread_pool(int thread_count = 0) {
+            if (thread_count <= 0)
+                thread_count = static_cast<int>(std::thread::hardware_concurrency());
+            worker_count = std::max(1, thread_count);
+        }
+
+        int size() const { return worker_count; }
+
+        // calls fn(task_index, worker_index) for every task in [0, task_count) and returns when all are done.
+        // the calling thread works as worker 0.
+        template <typename F>
+        void parallel_for(int task_count, F&& fn) const {
+            int workers = std::min(worker_count, task_count);
+            if (workers <= 1) {
+                for (int task = 0; task < task_count; task++)
+                    fn(task, 0);
+                return;
+            }
+
+            std::vector<task_queue> queues(workers);
+            for (int w = 0; w < workers; w++) {
+                int begin = static_cast<int>(static_cast<long long>(task_count) * w / workers);
+                int end = static_cast<int>(static_cast<long long>(task_count) * (w + 1) / workers);
+                for (int task = begin; task < end; task++)
+                    queues[w].tasks.push_back(task);
+            }
+
+            auto run = [&](int w) {
+                int task;
+                while (pop_front(queues[w], task) || steal(queues, w, task))
+                    fn(task, w);
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(workers - 1);
+            for (int w = 1; w < workers; w++)
+                threads.emplace_back(run, w);
+
+            run(0);
+
+            for (auto& t : threads)
+                t.join();
+        }
+
+    private:
+        struct task_queue {
+            std::mutex lock;
+            std::deque<int> tasks;
+        };
+
+        int worker_count;
+
+        static bool pop_front(task_queue& q, int& task) {
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty()) return false;
+            task = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+
+        static bool steal(std::vector<task_queue>& queues, int thief, int& task) {
+            int n = static_cast<int>(queues.size());
+            for (int k = 1; k < n; k++) {
+                auto& victim = queues[(thief + k) % n];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (victim.tasks.empty()) continue;
+                task = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
+            }
+            return false;
+        }
+    };
+}